@@ -0,0 +1,76 @@
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace Algorithm {
+template<typename Key, typename T>
+class LruCache
+{
+private:
+    using Entries = std::list<std::pair<Key, T>>;
+
+    Entries entries;
+    std::unordered_map<Key, typename Entries::iterator> index;
+    std::size_t capacity;
+
+public:
+    explicit LruCache(const std::size_t &capacity)
+        : capacity(capacity)
+    {}
+
+    const T *operator[](const Key &key)
+    {
+        const auto it = index.find(key);
+
+        if (it == index.end()) {
+            return nullptr;
+        }
+
+        entries.splice(entries.begin(), entries, it->second);
+
+        return &it->second->second;
+    }
+
+    void insert(const Key &key, const T &value)
+    {
+        if (const auto it = index.find(key); it != index.end()) {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+
+            return;
+        }
+
+        entries.emplace_front(key, value);
+        index.emplace(key, entries.begin());
+
+        while (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    void setCapacity(const std::size_t &capacity)
+    {
+        this->capacity = capacity;
+
+        while (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    void clear()
+    {
+        entries.clear();
+        index.clear();
+    }
+
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+};
+} // namespace Algorithm
+
+#endif
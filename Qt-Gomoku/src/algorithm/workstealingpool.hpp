@@ -0,0 +1,170 @@
+#ifndef WORKSTEALINGPOOL_HPP
+#define WORKSTEALINGPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace Algorithm {
+// Each worker runs the tasks of its own queue from the front and, when it is empty, steals
+// from the back of the other queues, so a few long tasks don't hold up the rest.
+// Tasks get the index of the worker running them, to use per worker resources.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(const std::size_t &)>;
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable taskDone;
+    std::size_t queued;
+    std::size_t pending;
+    std::size_t next;
+    bool stopping;
+
+    std::optional<Task> take(const std::size_t &worker)
+    {
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            auto &queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard lock(queue.mutex);
+
+            if (queue.tasks.empty()) {
+                continue;
+            }
+
+            auto task = std::move(i ? queue.tasks.back() : queue.tasks.front());
+
+            if (i) {
+                queue.tasks.pop_back();
+            } else {
+                queue.tasks.pop_front();
+            }
+
+            return task;
+        }
+
+        return std::nullopt;
+    }
+
+    void run(const std::size_t &worker)
+    {
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+
+                taskAvailable.wait(lock, [this] { return queued || stopping; });
+
+                if (!queued) {
+                    return;
+                }
+
+                --queued;
+            }
+
+            // A task is reserved, but another worker may pop it first, keep looking until found.
+            auto task = take(worker);
+
+            while (!task) {
+                std::this_thread::yield();
+
+                task = take(worker);
+            }
+
+            (*task)(worker);
+
+            {
+                std::lock_guard lock(mutex);
+
+                --pending;
+            }
+
+            taskDone.notify_all();
+        }
+    }
+
+public:
+    explicit WorkStealingPool(const std::size_t &count)
+        : queued(0)
+        , pending(0)
+        , next(0)
+        , stopping(false)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            threads.emplace_back(&WorkStealingPool::run, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Runs the remaining tasks before joining.
+    ~WorkStealingPool()
+    {
+        wait();
+
+        {
+            std::lock_guard lock(mutex);
+
+            stopping = true;
+        }
+
+        taskAvailable.notify_all();
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Spreads the tasks over the queues in turn, call it from one thread only.
+    void submit(Task task)
+    {
+        {
+            std::lock_guard lock(queues[next]->mutex);
+
+            queues[next]->tasks.push_back(std::move(task));
+        }
+
+        next = (next + 1) % queues.size();
+
+        {
+            std::lock_guard lock(mutex);
+
+            ++queued;
+            ++pending;
+        }
+
+        taskAvailable.notify_one();
+    }
+
+    // Blocks until at most limit tasks are queued or running.
+    void wait(const std::size_t &limit = 0)
+    {
+        std::unique_lock lock(mutex);
+
+        taskDone.wait(lock, [this, &limit] { return pending <= limit; });
+    }
+
+    [[nodiscard]] std::size_t size() const { return threads.size(); }
+};
+} // namespace Algorithm
+
+#endif
@@ -0,0 +1,102 @@
+#include "mappedfile.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOMOKU_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : address(nullptr)
+    , length(0)
+{}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &path, const bool &sequential)
+{
+    close();
+
+#ifdef GOMOKU_MMAP
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if (fstat(fd, &status) != 0) {
+        ::close(fd);
+
+        return false;
+    }
+
+    // An empty mapping is an error, an empty file just has no data.
+    if (status.st_size == 0) {
+        ::close(fd);
+
+        return true;
+    }
+
+    auto *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the file alive.
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    if (sequential) {
+        madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    }
+
+    address = static_cast<const unsigned char *>(mapping);
+    length = status.st_size;
+#else
+    static_cast<void>(sequential);
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file) {
+        return false;
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    address = buffer.data();
+    length = buffer.size();
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef GOMOKU_MMAP
+    if (address) {
+        munmap(const_cast<unsigned char *>(address), length);
+    }
+#endif
+
+    address = nullptr;
+    length = 0;
+    buffer.clear();
+}
+
+const unsigned char *MappedFile::data() const
+{
+    return address;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
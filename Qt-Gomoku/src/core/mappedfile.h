@@ -0,0 +1,28 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A whole file mapped read-only into memory where mmap exists, pages are then loaded on first
+// access. Elsewhere the file is read into a buffer.
+class MappedFile
+{
+private:
+    const unsigned char *address;
+    size_t length;
+    std::vector<unsigned char> buffer;
+
+public:
+    MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+    // sequential tells the system that the pages will mostly be read in order.
+    bool open(const std::string &path, const bool &sequential = false);
+    void close();
+    [[nodiscard]] const unsigned char *data() const;
+    [[nodiscard]] size_t size() const;
+};
+#endif
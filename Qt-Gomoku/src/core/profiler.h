@@ -0,0 +1,156 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped section timers for the search hot path, enabled by the GOMOKU_PROFILE build option.
+// Without it PROFILE_SCOPE expands to nothing and this header declares nothing else.
+
+#ifdef GOMOKU_PROFILE
+
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+
+namespace Profiler {
+enum Section {
+    EngineMove,
+    EngineUndo,
+    EvaluatorUpdate,
+    EvaluatorRestore,
+    Evaluate,
+    EvaluateMove,
+    IsFourMove,
+    GeneratorMove,
+    GeneratorUndo,
+    Generate,
+    TTProbe,
+    TTInsert,
+    CandidateSort,
+    MatedFilter,
+    NnueUpdate,
+    NnueEvaluate,
+    PolicyEvaluate,
+    SectionCount
+};
+
+inline constexpr std::array<const char *, SectionCount> sectionNames
+    = {"engine.move",
+       "engine.undo",
+       "evaluator.update",
+       "evaluator.restore",
+       "evaluator.evaluate",
+       "evaluator.evaluateMove",
+       "evaluator.isFourMove",
+       "generator.move",
+       "generator.undo",
+       "generator.generate",
+       "tt.probe",
+       "tt.insert",
+       "pvs.sort",
+       "pvs.matedFilter",
+       "nnue.update",
+       "nnue.evaluate",
+       "policy.evaluate"};
+
+struct Record
+{
+    unsigned long long calls = 0;
+    std::chrono::nanoseconds inclusive{0};
+    std::chrono::nanoseconds exclusive{0};
+};
+
+class ScopedTimer;
+
+inline thread_local std::array<Record, SectionCount> records{};
+inline thread_local ScopedTimer *current = nullptr;
+
+// Exclusive time is the inclusive time minus the time of the sections opened inside.
+class ScopedTimer
+{
+private:
+    Section section;
+    ScopedTimer *parent;
+    std::chrono::nanoseconds children{0};
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(const Section &section)
+        : section(section)
+        , parent(current)
+        , start(std::chrono::steady_clock::now())
+    {
+        current = this;
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    ~ScopedTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        auto &record = records[section];
+
+        ++record.calls;
+        record.inclusive += elapsed;
+        record.exclusive += elapsed - children;
+
+        if (parent) {
+            parent->children += elapsed;
+        }
+
+        current = parent;
+    }
+};
+
+inline void reset()
+{
+    records = {};
+}
+
+// Percentages are of the given total, usually the search time, the rest is outside of any section.
+inline void dump(std::ostream &stream, const std::chrono::nanoseconds &time)
+{
+    const auto total = time.count();
+    auto rest = time;
+
+    stream << std::left << std::setw(24) << "section" << std::right << std::setw(12) << "calls"
+           << std::setw(14) << "incl ms" << std::setw(14) << "excl ms" << std::setw(9) << "excl %"
+           << std::setw(12) << "ns/call" << '\n';
+
+    for (int i = 0; i < SectionCount; ++i) {
+        const auto &[calls, inclusive, exclusive] = records[i];
+
+        if (!calls) {
+            continue;
+        }
+
+        rest -= exclusive;
+
+        stream << std::left << std::setw(24) << sectionNames[i] << std::right << std::setw(12)
+               << calls << std::fixed << std::setprecision(3) << std::setw(14)
+               << inclusive.count() / 1e6 << std::setw(14) << exclusive.count() / 1e6
+               << std::setprecision(1) << std::setw(9)
+               << (total ? 100.0 * exclusive.count() / total : 0.0) << std::setw(12)
+               << static_cast<double>(inclusive.count()) / calls << std::defaultfloat << '\n';
+    }
+
+    stream << std::left << std::setw(24) << "rest" << std::right << std::setw(12) << '-'
+           << std::fixed << std::setprecision(3) << std::setw(14) << rest.count() / 1e6
+           << std::setw(14) << rest.count() / 1e6 << std::setprecision(1) << std::setw(9)
+           << (total ? 100.0 * rest.count() / total : 0.0) << std::setw(12) << '-'
+           << std::defaultfloat << std::endl;
+}
+} // namespace Profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(section) \
+    const Profiler::ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(Profiler::section)
+
+#else
+
+#define PROFILE_SCOPE(section)
+
+#endif
+
+#endif
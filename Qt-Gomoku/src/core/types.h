@@ -1,6 +1,9 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <cstddef>
+#include <functional>
+
 enum Score {
     One = 20,
     Two = 120,
@@ -16,4 +19,54 @@ enum Status { Draw = -1, Undecided, Win };
 
 enum Stone { Black = -1, Empty, White };
 
+struct Point
+{
+    int x;
+    int y;
+};
+
+constexpr Point operator+(const Point &lhs, const Point &rhs)
+{
+    return {lhs.x + rhs.x, lhs.y + rhs.y};
+}
+
+constexpr Point operator-(const Point &lhs, const Point &rhs)
+{
+    return {lhs.x - rhs.x, lhs.y - rhs.y};
+}
+
+constexpr Point operator*(const int &factor, const Point &point)
+{
+    return {factor * point.x, factor * point.y};
+}
+
+constexpr Point &operator+=(Point &lhs, const Point &rhs)
+{
+    lhs.x += rhs.x;
+    lhs.y += rhs.y;
+
+    return lhs;
+}
+
+constexpr bool operator==(const Point &lhs, const Point &rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+constexpr bool operator!=(const Point &lhs, const Point &rhs)
+{
+    return !(lhs == rhs);
+}
+
+namespace std {
+template<>
+struct hash<Point>
+{
+    size_t operator()(const Point &point) const noexcept
+    {
+        return static_cast<size_t>(point.x * 15 + point.y);
+    }
+};
+} // namespace std
+
 #endif
@@ -1,28 +1,36 @@
 #include "evaluator.h"
-
-#include <QCache>
-#include <QHash>
-#include <QList>
-#include <QtGlobal>
+#include "../algorithm/lrucache.hpp"
+#include "../core/profiler.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <limits>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
 #ifdef emit
 #undef emit
-#include "../algorithm/aho_corasick.hpp"
 #endif
+#include "../algorithm/aho_corasick.hpp"
 
 using namespace Evaluation;
 
 namespace {
+// A cached line with its list and index nodes, about 140 to 160 bytes with libstdc++.
+constexpr size_t CACHE_ENTRY_SIZE = 160;
+
 aho_corasick::trie trie;
 aho_corasick::trie fourTrie;
-QCache<std::string, bool> fourCache = QCache<std::string, bool>{1 << 16};
-QCache<std::string, int> scoreCache = QCache<std::string, int>{1 << 23};
-const QHash<std::string, Score> shapeScoreTable = {{"00100", One},
+// Per thread, so that engines searching on different threads don't share them.
+// scoreCache holds the Score sums used for move ordering and threats, countCache the shapes of
+// whole lines, weighted by each evaluator.
+thread_local Algorithm::LruCache<std::string, bool> fourCache{1 << 16};
+thread_local Algorithm::LruCache<std::string, int> scoreCache{1 << 23};
+thread_local Algorithm::LruCache<std::string, std::array<unsigned char, SHAPES.size()>> countCache{
+    1 << 20};
+const std::unordered_map<std::string, Score> shapeScoreTable = {{"00100", One},
                                                    {"01010", Two},
                                                    {"00110", Two},
                                                    {"01100", Two},
@@ -36,6 +44,45 @@ const QHash<std::string, Score> shapeScoreTable = {{"00100", One},
                                                    {"11101", Four},
                                                    {"011110", OpenFour},
                                                    {"11111", Five}};
+
+size_t shapeIndex(const std::string &shape)
+{
+    static const auto indices = [] {
+        std::unordered_map<std::string, size_t> indices;
+
+        for (size_t i = 0; i < SHAPES.size(); ++i) {
+            indices.emplace(SHAPES[i], i);
+        }
+
+        return indices;
+    }();
+
+    return indices.at(shape);
+}
+
+// The tries are shared by all evaluators, inserting the shapes again would duplicate matches.
+// Their failure states are built on the first parse, do it here so that later parses only read.
+void initialize()
+{
+    [[maybe_unused]] static const bool initialized = [] {
+        trie.only_whole_words();
+        fourTrie.only_whole_words();
+
+        for (const auto &[shape, _] : shapeScoreTable) {
+            trie.insert(shape);
+        }
+
+        fourTrie.insert("11110");
+        fourTrie.insert("01111");
+        fourTrie.insert("10111");
+        fourTrie.insert("11011");
+        fourTrie.insert("11101");
+        trie.parse_text("");
+        fourTrie.parse_text("");
+
+        return true;
+    }();
+}
 } // namespace
 
 Evaluator::Evaluator(std::array<std::string, 72> *blackShapes,
@@ -46,44 +93,98 @@ Evaluator::Evaluator(std::array<std::string, 72> *blackShapes,
     , whiteScores({})
     , blackTotalScore(0)
     , whiteTotalScore(0)
+    , weights(defaultWeights())
+{
+    initialize();
+}
+
+int Evaluator::lineScore(const std::string &line) const
+{
+    const auto *cacheCounts = countCache[line];
+    std::array<unsigned char, SHAPES.size()> counts{};
+
+    if (!cacheCounts) {
+        for (const auto &shape : trie.parse_text(line)) {
+            ++counts[shapeIndex(shape.get_keyword())];
+        }
+
+        countCache.insert(line, counts);
+        cacheCounts = &counts;
+    }
+
+    int score = 0;
+
+    for (size_t i = 0; i < SHAPES.size(); ++i) {
+        score += weights[i] * (*cacheCounts)[i];
+    }
+
+    return score;
+}
+
+// Rescores the current lines, the scores saved for restore() keep the old weights.
+void Evaluator::setWeights(const Weights &weights)
 {
-    trie.only_whole_words();
-    fourTrie.only_whole_words();
+    this->weights = weights;
 
-    for (auto it = shapeScoreTable.cbegin(); it != shapeScoreTable.cend(); ++it) {
-        trie.insert(it.key());
+    blackTotalScore = 0;
+    whiteTotalScore = 0;
+
+    for (size_t i = 0; i < blackScores.size(); ++i) {
+        blackScores[i] = lineScore((*blackShapes)[i]);
+        whiteScores[i] = lineScore((*whiteShapes)[i]);
+        blackTotalScore += blackScores[i];
+        whiteTotalScore += whiteScores[i];
     }
+}
+
+void Evaluator::setCacheSize(const size_t &bytes)
+{
+    const auto entries = std::max<size_t>(bytes / CACHE_ENTRY_SIZE, 16);
+    // The default proportions: the four cache is small, the score cache takes the most lines.
+    const auto fourEntries = entries / 128 + 1;
+    const auto countEntries = entries / 9 + 1;
+
+    fourCache.setCapacity(fourEntries);
+    countCache.setCapacity(countEntries);
+    scoreCache.setCapacity(entries - fourEntries - countEntries);
+}
+
+void Evaluator::countShapes(const std::string &line, ShapeCounts &counts)
+{
+    initialize();
 
-    fourTrie.insert("11110");
-    fourTrie.insert("01111");
-    fourTrie.insert("10111");
-    fourTrie.insert("11011");
-    fourTrie.insert("11101");
+    for (const auto &shape : trie.parse_text(line)) {
+        ++counts[shapeIndex(shape.get_keyword())];
+    }
 }
 
 void Evaluator::restore()
 {
-    blackScores = history.blackScores.top();
-    whiteScores = history.whiteScores.top();
-    blackTotalScore = history.blackTotalScores.top();
-    whiteTotalScore = history.whiteTotalScores.top();
-    history.blackScores.pop();
-    history.whiteScores.pop();
-    history.blackTotalScores.pop();
-    history.whiteTotalScores.pop();
+    PROFILE_SCOPE(EvaluatorRestore);
+
+    blackScores = history.blackScores.back();
+    whiteScores = history.whiteScores.back();
+    blackTotalScore = history.blackTotalScores.back();
+    whiteTotalScore = history.whiteTotalScores.back();
+    history.blackScores.pop_back();
+    history.whiteScores.pop_back();
+    history.blackTotalScores.pop_back();
+    history.whiteTotalScores.pop_back();
 }
 
-void Evaluator::update(const QPoint &move)
+void Evaluator::update(const Point &move)
 {
-    history.blackScores.push(blackScores);
-    history.whiteScores.push(whiteScores);
-    history.blackTotalScores.push(blackTotalScore);
-    history.whiteTotalScores.push(whiteTotalScore);
+    PROFILE_SCOPE(EvaluatorUpdate);
+
+    history.blackScores.push_back(blackScores);
+    history.whiteScores.push_back(whiteScores);
+    history.blackTotalScores.push_back(blackTotalScore);
+    history.whiteTotalScores.push_back(whiteTotalScore);
 
     std::array<int, 4> blackLineScores{};
     std::array<int, 4> whiteLineScores{};
     const auto &[x, y] = move;
-    const std::array<bool, 4> valid = {true, true, qAbs(y - x) <= 10, x + y >= 4 && x + y <= 24};
+    const std::array<bool, 4> valid = {true, true, std::abs(y - x) <= 10, x + y >= 4 && x + y <= 24};
     const std::reference_wrapper<const std::string> blackLines[]
         = {(*blackShapes)[y],
            (*blackShapes)[x + 15],
@@ -97,29 +198,8 @@ void Evaluator::update(const QPoint &move)
 
     for (size_t i = 0; i < 4; ++i) {
         if (valid[i]) {
-            if (const auto &cacheScore = scoreCache[blackLines[i]]) {
-                blackLineScores[i] = *cacheScore;
-            } else {
-                const auto shapes = trie.parse_text(blackLines[i]);
-
-                for (const auto &shape : shapes) {
-                    blackLineScores[i] += shapeScoreTable[shape.get_keyword()];
-                }
-
-                scoreCache.insert(blackLines[i], new int(blackLineScores[i]));
-            }
-
-            if (const auto &cacheScore = scoreCache[whiteLines[i]]) {
-                whiteLineScores[i] = *cacheScore;
-            } else {
-                const auto shapes = trie.parse_text(whiteLines[i]);
-
-                for (const auto &shape : shapes) {
-                    whiteLineScores[i] += shapeScoreTable[shape.get_keyword()];
-                }
-
-                scoreCache.insert(whiteLines[i], new int(whiteLineScores[i]));
-            }
+            blackLineScores[i] = lineScore(blackLines[i]);
+            whiteLineScores[i] = lineScore(whiteLines[i]);
         }
     }
 
@@ -144,12 +224,14 @@ void Evaluator::update(const QPoint &move)
     }
 }
 
-bool Evaluator::isFourMove(const QPoint &move, const Stone &stone) const
+bool Evaluator::isFourMove(const Point &move, const Stone &stone) const
 {
+    PROFILE_SCOPE(IsFourMove);
+
     const auto &[x, y] = move;
 
     for (int d = 0; d < 4; ++d) {
-        if (d == 2 && qAbs(y - x) > 10) {
+        if (d == 2 && std::abs(y - x) > 10) {
             continue;
         }
 
@@ -164,7 +246,7 @@ bool Evaluator::isFourMove(const QPoint &move, const Stone &stone) const
 
         size_t count = offset < 0 ? offset + 9 : 9;
 
-        offset = qMax(0, offset);
+        offset = std::max(0, offset);
 
         if (offset + count > stoneLine.size()) {
             count = stoneLine.size() - offset;
@@ -183,12 +265,12 @@ bool Evaluator::isFourMove(const QPoint &move, const Stone &stone) const
         const auto shapes = fourTrie.parse_text(stoneLine);
 
         if (!shapes.empty()) {
-            fourCache.insert(stoneLine, new bool(true));
+            fourCache.insert(stoneLine, true);
 
             return true;
         }
 
-        fourCache.insert(stoneLine, new bool(false));
+        fourCache.insert(stoneLine, false);
     }
 
     return false;
@@ -196,14 +278,32 @@ bool Evaluator::isFourMove(const QPoint &move, const Stone &stone) const
 
 int Evaluator::evaluate(const Stone &stone) const
 {
-    return stone == Black ? blackTotalScore : whiteTotalScore;
+    PROFILE_SCOPE(Evaluate);
+
+    const auto score = stone == Black ? blackTotalScore : whiteTotalScore;
+
+    // Tuned weights may add up to Five without a five on the board, the search must not take
+    // that for a win.
+    if (score >= Five) {
+        const auto &shapes = stone == Black ? *blackShapes : *whiteShapes;
+
+        if (std::none_of(shapes.cbegin(), shapes.cend(), [](const auto &line) {
+                return line.find("11111") != std::string::npos;
+            })) {
+            return Five - 1;
+        }
+    }
+
+    return score;
 }
 
-QPair<int, int> Evaluator::evaluateMove(const QPoint &move, const int &direction) const
+std::pair<int, int> Evaluator::evaluateMove(const Point &move, const int &direction) const
 {
+    PROFILE_SCOPE(EvaluateMove);
+
     const auto &[x, y] = move;
 
-    if (direction == 2 && qAbs(y - x) > 10) {
+    if (direction == 2 && std::abs(y - x) > 10) {
         return {0, 0};
     }
 
@@ -220,7 +320,7 @@ QPair<int, int> Evaluator::evaluateMove(const QPoint &move, const int &direction
 
     size_t count = offset < 0 ? offset + 9 : 9;
 
-    offset = qMax(0, offset);
+    offset = std::max(0, offset);
 
     if (offset + count > blackLine.size()) {
         count = blackLine.size() - offset;
@@ -234,16 +334,16 @@ QPair<int, int> Evaluator::evaluateMove(const QPoint &move, const int &direction
     if (const auto &cacheScore = scoreCache[blackLine]) {
         blackScore += *cacheScore;
     } else {
-        const auto accumulateScore = new int(0);
+        int accumulateScore = 0;
         const auto shapes = trie.parse_text(blackLine);
 
         for (const auto &shape : shapes) {
-            *accumulateScore += shapeScoreTable[shape.get_keyword()];
+            accumulateScore += shapeScoreTable.at(shape.get_keyword());
         }
 
         scoreCache.insert(blackLine, accumulateScore);
 
-        blackScore += *accumulateScore;
+        blackScore += accumulateScore;
     }
 
     int whiteScore = 0;
@@ -251,22 +351,22 @@ QPair<int, int> Evaluator::evaluateMove(const QPoint &move, const int &direction
     if (const auto &cacheScore = scoreCache[whiteLine]) {
         whiteScore += *cacheScore;
     } else {
-        const auto accumulateScore = new int(0);
+        int accumulateScore = 0;
         const auto shapes = trie.parse_text(whiteLine);
 
         for (const auto &shape : shapes) {
-            *accumulateScore += shapeScoreTable[shape.get_keyword()];
+            accumulateScore += shapeScoreTable.at(shape.get_keyword());
         }
 
         scoreCache.insert(whiteLine, accumulateScore);
 
-        whiteScore += *accumulateScore;
+        whiteScore += accumulateScore;
     }
 
     return {blackScore, whiteScore};
 }
 
-QPair<int, int> Evaluator::lineOffsetPair(const QPoint &move, const int &direction)
+std::pair<int, int> Evaluator::lineOffsetPair(const Point &move, const int &direction)
 {
     int line;
     int offset;
@@ -285,12 +385,12 @@ QPair<int, int> Evaluator::lineOffsetPair(const QPoint &move, const int &directi
         break;
     case 2:
         line = y - x + 40;
-        offset = qMin(x, y) - 4;
+        offset = std::min(x, y) - 4;
 
         break;
     case 3:
         line = x + y + 47;
-        offset = qMin(y, 14 - x) - 4;
+        offset = std::min(y, 14 - x) - 4;
 
         break;
     }
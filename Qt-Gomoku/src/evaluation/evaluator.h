@@ -2,20 +2,20 @@
 #define EVALUATOR_H
 
 #include "../core/types.h"
-
-#include <QPoint>
-#include <QStack>
+#include "weights.h"
 
 #include <array>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Evaluation {
 struct History
 {
-    QStack<std::array<int, 72>> blackScores;
-    QStack<std::array<int, 72>> whiteScores;
-    QStack<int> blackTotalScores;
-    QStack<int> whiteTotalScores;
+    std::vector<std::array<int, 72>> blackScores;
+    std::vector<std::array<int, 72>> whiteScores;
+    std::vector<int> blackTotalScores;
+    std::vector<int> whiteTotalScores;
 };
 
 class Evaluator
@@ -28,16 +28,24 @@ private:
     std::array<int, 72> whiteScores;
     int blackTotalScore;
     int whiteTotalScore;
+    Weights weights;
+
+    [[nodiscard]] int lineScore(const std::string &line) const;
 
 public:
     Evaluator() = delete;
     Evaluator(std::array<std::string, 72> *blackShapes, std::array<std::string, 72> *whiteShapes);
     void restore();
-    void update(const QPoint &move);
-    [[nodiscard]] bool isFourMove(const QPoint &move, const Stone &stone) const;
+    void update(const Point &move);
+    [[nodiscard]] bool isFourMove(const Point &move, const Stone &stone) const;
     [[nodiscard]] int evaluate(const Stone &stone) const;
-    [[nodiscard]] QPair<int, int> evaluateMove(const QPoint &move, const int &direction) const;
-    static QPair<int, int> lineOffsetPair(const QPoint &move, const int &direction);
+    [[nodiscard]] std::pair<int, int> evaluateMove(const Point &move, const int &direction) const;
+    void setWeights(const Weights &weights);
+    // Bounds the shape caches of the calling thread to about bytes, they hold up to about
+    // 1.4 GB otherwise.
+    static void setCacheSize(const size_t &bytes);
+    static void countShapes(const std::string &line, ShapeCounts &counts);
+    static std::pair<int, int> lineOffsetPair(const Point &move, const int &direction);
 };
 } // namespace Evaluation
 #endif
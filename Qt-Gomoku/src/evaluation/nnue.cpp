@@ -0,0 +1,259 @@
+#include "nnue.h"
+#include "../core/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define GOMOKU_NNUE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define GOMOKU_NNUE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Evaluation;
+
+namespace {
+constexpr char MAGIC[] = "QTGMKNN1";
+
+int perspectiveIndex(const Stone &perspective)
+{
+    return perspective == Black ? 0 : 1;
+}
+
+template<typename T>
+bool read(std::istream &stream, T &value)
+{
+    std::make_unsigned_t<T> bits = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        const auto byte = stream.get();
+
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+
+        bits |= static_cast<std::make_unsigned_t<T>>(static_cast<unsigned char>(byte)) << 8 * i;
+    }
+
+    value = static_cast<T>(bits);
+
+    return true;
+}
+
+template<typename T>
+void write(std::ostream &stream, const T &value)
+{
+    const auto bits = static_cast<std::make_unsigned_t<T>>(value);
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        stream.put(static_cast<char>(bits >> 8 * i & 0xff));
+    }
+}
+
+template<typename T, size_t N>
+bool read(std::istream &stream, std::array<T, N> &values)
+{
+    for (auto &value : values) {
+        if (!read(stream, value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T, size_t N>
+void write(std::ostream &stream, const std::array<T, N> &values)
+{
+    for (const auto &value : values) {
+        write(stream, value);
+    }
+}
+
+// values += sign * row, 16 lanes at a time with AVX2, 8 with SSE2.
+void addRow(std::int16_t *values, const std::int16_t *row, const bool &subtract)
+{
+#if defined(GOMOKU_NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        auto *target = reinterpret_cast<__m256i *>(values + i);
+        const auto source = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        const auto current = _mm256_loadu_si256(target);
+
+        _mm256_storeu_si256(target,
+                            subtract ? _mm256_sub_epi16(current, source)
+                                     : _mm256_add_epi16(current, source));
+    }
+#elif defined(GOMOKU_NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        auto *target = reinterpret_cast<__m128i *>(values + i);
+        const auto source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        const auto current = _mm_loadu_si128(target);
+
+        _mm_storeu_si128(target,
+                         subtract ? _mm_sub_epi16(current, source) : _mm_add_epi16(current, source));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        values[i] = static_cast<std::int16_t>(subtract ? values[i] - row[i] : values[i] + row[i]);
+    }
+#endif
+}
+
+// Sum of clamp(values, 0, NNUE_QA) * weights.
+std::int32_t clippedDot(const std::int16_t *values, const std::int16_t *weights)
+{
+#if defined(GOMOKU_NNUE_AVX2)
+    const auto zero = _mm256_setzero_si256();
+    const auto ceiling = _mm256_set1_epi16(NNUE_QA);
+    auto sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        const auto weight = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+        const auto clipped = _mm256_min_epi16(_mm256_max_epi16(value, zero), ceiling);
+
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(clipped, weight));
+    }
+
+    auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(half);
+#elif defined(GOMOKU_NNUE_SSE2)
+    const auto zero = _mm_setzero_si128();
+    const auto ceiling = _mm_set1_epi16(NNUE_QA);
+    auto sum = _mm_setzero_si128();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        const auto weight = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+        const auto clipped = _mm_min_epi16(_mm_max_epi16(value, zero), ceiling);
+
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(clipped, weight));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(sum);
+#else
+    std::int32_t sum = 0;
+
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        const std::int32_t clipped = values[i] < 0 ? 0 : values[i] > NNUE_QA ? NNUE_QA : values[i];
+
+        sum += clipped * weights[i];
+    }
+
+    return sum;
+#endif
+}
+} // namespace
+
+int Evaluation::nnueFeature(const Point &point, const Stone &stone, const Stone &perspective)
+{
+    return (stone == perspective ? 0 : 225) + point.x * 15 + point.y;
+}
+
+std::shared_ptr<const Network> Evaluation::loadNetwork(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC) - 1];
+    std::uint32_t hidden = 0;
+    auto network = std::make_shared<Network>();
+
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(magic)) != 0
+        || !read(file, hidden) || hidden != NNUE_HIDDEN) {
+        return nullptr;
+    }
+
+    for (auto &row : network->featureWeights) {
+        if (!read(file, row)) {
+            return nullptr;
+        }
+    }
+
+    if (!read(file, network->featureBiases) || !read(file, network->outputWeights)
+        || !read(file, network->outputBias) || !read(file, network->scale)
+        || network->scale <= 0 || network->scale > NNUE_MAX_SCALE) {
+        return nullptr;
+    }
+
+    return network;
+}
+
+bool Evaluation::saveNetwork(const std::string &path, const Network &network)
+{
+    std::ofstream file(path, std::ios::binary);
+
+    file.write(MAGIC, sizeof(MAGIC) - 1);
+    write(file, static_cast<std::uint32_t>(NNUE_HIDDEN));
+
+    for (const auto &row : network.featureWeights) {
+        write(file, row);
+    }
+
+    write(file, network.featureBiases);
+    write(file, network.outputWeights);
+    write(file, network.outputBias);
+    write(file, network.scale);
+
+    return static_cast<bool>(file);
+}
+
+Accumulator::Accumulator()
+    : network(nullptr)
+    , values({})
+{}
+
+void Accumulator::reset(const Network *network)
+{
+    this->network = network;
+
+    if (network) {
+        values.fill(network->featureBiases);
+    }
+}
+
+void Accumulator::add(const Point &point, const Stone &stone)
+{
+    PROFILE_SCOPE(NnueUpdate);
+
+    for (const auto perspective : {Black, White}) {
+        addRow(values[perspectiveIndex(perspective)].data(),
+               network->featureWeights[nnueFeature(point, stone, perspective)].data(),
+               false);
+    }
+}
+
+void Accumulator::remove(const Point &point, const Stone &stone)
+{
+    PROFILE_SCOPE(NnueUpdate);
+
+    for (const auto perspective : {Black, White}) {
+        addRow(values[perspectiveIndex(perspective)].data(),
+               network->featureWeights[nnueFeature(point, stone, perspective)].data(),
+               true);
+    }
+}
+
+int Accumulator::evaluate(const Stone &stone) const
+{
+    PROFILE_SCOPE(NnueEvaluate);
+
+    const auto &own = values[perspectiveIndex(stone)];
+    const auto &opponent = values[1 - perspectiveIndex(stone)];
+    const auto sum = static_cast<long long>(network->outputBias)
+                     + clippedDot(own.data(), network->outputWeights.data())
+                     + clippedDot(opponent.data(), network->outputWeights.data() + NNUE_HIDDEN);
+
+    // Within the static scores, the search takes anything beyond for a five or a mate.
+    return static_cast<int>(
+        std::clamp(sum * network->scale / (NNUE_QA * NNUE_QB), -(Five - 1LL), Five - 1LL));
+}
@@ -0,0 +1,60 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "../core/types.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Evaluation {
+// A small efficiently updatable network: 450 inputs per perspective (own stone on a cell, then
+// opponent stone on a cell), one int16 hidden layer per perspective clipped to [0, NNUE_QA],
+// and a linear output over both hidden layers, side to move first.
+inline constexpr int NNUE_INPUTS = 2 * 225;
+inline constexpr int NNUE_HIDDEN = 128;
+// Quantization: the hidden layer is scaled by NNUE_QA, the output weights by NNUE_QB.
+inline constexpr int NNUE_QA = 255;
+inline constexpr int NNUE_QB = 64;
+// Networks are trained to sigmoid(score / scale) with scales in the hundreds, a larger one means
+// another score range and is refused.
+inline constexpr int NNUE_MAX_SCALE = 10000;
+
+struct Network
+{
+    alignas(32) std::array<std::array<std::int16_t, NNUE_HIDDEN>, NNUE_INPUTS> featureWeights;
+    alignas(32) std::array<std::int16_t, NNUE_HIDDEN> featureBiases;
+    alignas(32) std::array<std::int16_t, 2 * NNUE_HIDDEN> outputWeights;
+    std::int32_t outputBias;
+    // Score of an output of NNUE_QA * NNUE_QB.
+    std::int32_t scale;
+};
+
+// Input feature of a stone seen from the perspective of the given side.
+[[nodiscard]] int nnueFeature(const Point &point, const Stone &stone, const Stone &perspective);
+
+// Binary form: "QTGMKNN1", hidden size as a little-endian uint32, then the members in order as
+// little-endian integers. nullptr when the file is missing, doesn't match NNUE_HIDDEN or its
+// scale is outside (0, NNUE_MAX_SCALE].
+[[nodiscard]] std::shared_ptr<const Network> loadNetwork(const std::string &path);
+bool saveNetwork(const std::string &path, const Network &network);
+
+// The hidden layers of both perspectives, updated by adding or removing one stone.
+class Accumulator
+{
+private:
+    const Network *network;
+    alignas(32) std::array<std::array<std::int16_t, NNUE_HIDDEN>, 2> values;
+
+public:
+    Accumulator();
+    // Starts from an empty board.
+    void reset(const Network *network);
+    void add(const Point &point, const Stone &stone);
+    void remove(const Point &point, const Stone &stone);
+    // Score from the given side's point of view.
+    [[nodiscard]] int evaluate(const Stone &stone) const;
+};
+} // namespace Evaluation
+#endif
@@ -0,0 +1,397 @@
+#include "policy.h"
+#include "../core/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define GOMOKU_POLICY_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define GOMOKU_POLICY_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Evaluation;
+
+namespace {
+constexpr char MAGIC[] = "QTGMKPN1";
+
+// Hidden layers with a zero border, so the 3x3 kernels need no bounds checks.
+using Plane = std::array<std::array<std::array<std::int16_t, POLICY_CHANNELS>, 17>, 17>;
+
+template<typename T>
+bool read(std::istream &stream, T &value)
+{
+    std::make_unsigned_t<T> bits = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        const auto byte = stream.get();
+
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+
+        bits |= static_cast<std::make_unsigned_t<T>>(static_cast<unsigned char>(byte)) << 8 * i;
+    }
+
+    value = static_cast<T>(bits);
+
+    return true;
+}
+
+template<typename T>
+void write(std::ostream &stream, const T &value)
+{
+    const auto bits = static_cast<std::make_unsigned_t<T>>(value);
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        stream.put(static_cast<char>(bits >> 8 * i & 0xff));
+    }
+}
+
+template<typename T, size_t N>
+bool read(std::istream &stream, std::array<T, N> &values)
+{
+    for (auto &value : values) {
+        if (!read(stream, value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T, size_t N>
+void write(std::ostream &stream, const std::array<T, N> &values)
+{
+    for (const auto &value : values) {
+        write(stream, value);
+    }
+}
+
+// values += row over all channels.
+void addChannels(std::int16_t *values, const std::int16_t *row)
+{
+#if defined(GOMOKU_POLICY_AVX2)
+    auto *target = reinterpret_cast<__m256i *>(values);
+
+    _mm256_storeu_si256(target,
+                        _mm256_add_epi16(_mm256_loadu_si256(target),
+                                         _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row))));
+#elif defined(GOMOKU_POLICY_SSE2)
+    for (int i = 0; i < POLICY_CHANNELS; i += 8) {
+        auto *target = reinterpret_cast<__m128i *>(values + i);
+
+        _mm_storeu_si128(target,
+                         _mm_add_epi16(_mm_loadu_si128(target),
+                                       _mm_loadu_si128(
+                                           reinterpret_cast<const __m128i *>(row + i))));
+    }
+#else
+    for (int i = 0; i < POLICY_CHANNELS; ++i) {
+        values[i] = static_cast<std::int16_t>(values[i] + row[i]);
+    }
+#endif
+}
+
+void clipChannels(std::int16_t *values)
+{
+#if defined(GOMOKU_POLICY_AVX2)
+    auto *target = reinterpret_cast<__m256i *>(values);
+
+    _mm256_storeu_si256(target,
+                        _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256(target),
+                                                          _mm256_setzero_si256()),
+                                         _mm256_set1_epi16(POLICY_QA)));
+#elif defined(GOMOKU_POLICY_SSE2)
+    for (int i = 0; i < POLICY_CHANNELS; i += 8) {
+        auto *target = reinterpret_cast<__m128i *>(values + i);
+
+        _mm_storeu_si128(target,
+                         _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128(target), _mm_setzero_si128()),
+                                       _mm_set1_epi16(POLICY_QA)));
+    }
+#else
+    for (int i = 0; i < POLICY_CHANNELS; ++i) {
+        values[i] = std::clamp<std::int16_t>(values[i], 0, POLICY_QA);
+    }
+#endif
+}
+
+// Second layer at one cell: bias plus the 3x3 kernel over the padded first layer, shifted back
+// to the activation scale and clipped.
+void convolveCell(const PolicyNetwork &network,
+                  const Plane &input,
+                  const int &x,
+                  const int &y,
+                  std::int16_t *output)
+{
+#if defined(GOMOKU_POLICY_AVX2)
+    auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(network.secondBiases.data()));
+    auto high = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(network.secondBiases.data() + 8));
+
+    for (int k = 0; k < 9; ++k) {
+        const auto *values = input[x + k / 3][y + k % 3].data();
+
+        for (int pair = 0; pair < POLICY_CHANNELS / 2; ++pair) {
+            std::int32_t packed;
+
+            std::memcpy(&packed, values + 2 * pair, sizeof(packed));
+
+            const auto broadcast = _mm256_set1_epi32(packed);
+            const auto *weights = network.secondWeights[k][pair].data()->data();
+
+            low = _mm256_add_epi32(low,
+                                   _mm256_madd_epi16(broadcast,
+                                                     _mm256_loadu_si256(
+                                                         reinterpret_cast<const __m256i *>(weights))));
+            high = _mm256_add_epi32(high,
+                                    _mm256_madd_epi16(broadcast,
+                                                      _mm256_loadu_si256(
+                                                          reinterpret_cast<const __m256i *>(
+                                                              weights + 16))));
+        }
+    }
+
+    const auto shift = [](const __m256i &sum) {
+        return _mm256_srai_epi32(sum, 6);
+    };
+    // packs interleaves the 128-bit lanes, permute restores channel order.
+    const auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(shift(low), shift(high)),
+                                                 _MM_SHUFFLE(3, 1, 2, 0));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output),
+                        _mm256_min_epi16(_mm256_max_epi16(packed, _mm256_setzero_si256()),
+                                         _mm256_set1_epi16(POLICY_QA)));
+#elif defined(GOMOKU_POLICY_SSE2)
+    __m128i sums[POLICY_CHANNELS / 4];
+
+    for (int i = 0; i < POLICY_CHANNELS / 4; ++i) {
+        sums[i] = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(network.secondBiases.data() + 4 * i));
+    }
+
+    for (int k = 0; k < 9; ++k) {
+        const auto *values = input[x + k / 3][y + k % 3].data();
+
+        for (int pair = 0; pair < POLICY_CHANNELS / 2; ++pair) {
+            std::int32_t packed;
+
+            std::memcpy(&packed, values + 2 * pair, sizeof(packed));
+
+            const auto broadcast = _mm_set1_epi32(packed);
+            const auto *weights = network.secondWeights[k][pair].data()->data();
+
+            for (int i = 0; i < POLICY_CHANNELS / 4; ++i) {
+                sums[i] = _mm_add_epi32(sums[i],
+                                        _mm_madd_epi16(broadcast,
+                                                       _mm_loadu_si128(
+                                                           reinterpret_cast<const __m128i *>(
+                                                               weights + 8 * i))));
+            }
+        }
+    }
+
+    for (int i = 0; i < POLICY_CHANNELS / 8; ++i) {
+        const auto packed = _mm_packs_epi32(_mm_srai_epi32(sums[2 * i], 6),
+                                            _mm_srai_epi32(sums[2 * i + 1], 6));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 8 * i),
+                         _mm_min_epi16(_mm_max_epi16(packed, _mm_setzero_si128()),
+                                       _mm_set1_epi16(POLICY_QA)));
+    }
+#else
+    std::array<std::int32_t, POLICY_CHANNELS> sums = network.secondBiases;
+
+    for (int k = 0; k < 9; ++k) {
+        const auto *values = input[x + k / 3][y + k % 3].data();
+
+        for (int pair = 0; pair < POLICY_CHANNELS / 2; ++pair) {
+            for (int channel = 0; channel < POLICY_CHANNELS; ++channel) {
+                const auto &weights = network.secondWeights[k][pair][channel];
+
+                sums[channel] += values[2 * pair] * weights[0] + values[2 * pair + 1] * weights[1];
+            }
+        }
+    }
+
+    for (int channel = 0; channel < POLICY_CHANNELS; ++channel) {
+        output[channel] = static_cast<std::int16_t>(std::clamp(sums[channel] >> 6, 0, POLICY_QA));
+    }
+#endif
+}
+
+std::int16_t logit(const PolicyNetwork &network, const std::int16_t *values)
+{
+    std::int32_t sum = 0;
+
+    for (int channel = 0; channel < POLICY_CHANNELS; ++channel) {
+        sum += values[channel] * network.outputWeights[channel];
+    }
+
+    return static_cast<std::int16_t>(std::clamp(sum / POLICY_QA, -32768, 32767));
+}
+} // namespace
+
+static_assert(POLICY_QW == 1 << 6, "convolveCell shifts the second layer by log2(POLICY_QW)");
+
+std::shared_ptr<const PolicyNetwork> Evaluation::loadPolicy(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC) - 1];
+    std::uint32_t channels = 0;
+    auto network = std::make_shared<PolicyNetwork>();
+
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(magic)) != 0
+        || !read(file, channels) || channels != POLICY_CHANNELS) {
+        return nullptr;
+    }
+
+    for (auto &plane : network->firstWeights) {
+        for (auto &row : plane) {
+            if (!read(file, row)) {
+                return nullptr;
+            }
+        }
+    }
+
+    if (!read(file, network->firstBiases)) {
+        return nullptr;
+    }
+
+    for (auto &kernel : network->secondWeights) {
+        for (auto &pair : kernel) {
+            for (auto &weights : pair) {
+                if (!read(file, weights)) {
+                    return nullptr;
+                }
+            }
+        }
+    }
+
+    if (!read(file, network->secondBiases) || !read(file, network->outputWeights)) {
+        return nullptr;
+    }
+
+    return network;
+}
+
+bool Evaluation::savePolicy(const std::string &path, const PolicyNetwork &network)
+{
+    std::ofstream file(path, std::ios::binary);
+
+    file.write(MAGIC, sizeof(MAGIC) - 1);
+    write(file, static_cast<std::uint32_t>(POLICY_CHANNELS));
+
+    for (const auto &plane : network.firstWeights) {
+        for (const auto &row : plane) {
+            write(file, row);
+        }
+    }
+
+    write(file, network.firstBiases);
+
+    for (const auto &kernel : network.secondWeights) {
+        for (const auto &pair : kernel) {
+            for (const auto &weights : pair) {
+                write(file, weights);
+            }
+        }
+    }
+
+    write(file, network.secondBiases);
+    write(file, network.outputWeights);
+
+    return static_cast<bool>(file);
+}
+
+void Evaluation::evaluatePolicy(const PolicyNetwork &network,
+                                const std::vector<PolicyInput> &inputs,
+                                std::vector<PolicyLogits> &outputs)
+{
+    PROFILE_SCOPE(PolicyEvaluate);
+
+    std::vector<Plane> first(inputs.size());
+    Plane second{};
+
+    outputs.resize(inputs.size());
+
+    // First layer: biases, then the kernel rows of every stone added to its neighbours.
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const auto &[board, stone] = inputs[i];
+        auto &plane = first[i];
+
+        plane = {};
+
+        for (int x = 1; x <= 15; ++x) {
+            for (int y = 1; y <= 15; ++y) {
+                plane[x][y] = network.firstBiases;
+            }
+        }
+
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                if (board[x][y] == Empty) {
+                    continue;
+                }
+
+                const auto &weights = network.firstWeights[board[x][y] == stone ? 0 : 1];
+
+                // The stone is at offset (dx, dy) of the cell (x - dx, y - dy).
+                for (int dx = -1; dx <= 1; ++dx) {
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        if (x - dx >= 0 && x - dx < 15 && y - dy >= 0 && y - dy < 15) {
+                            addChannels(plane[x - dx + 1][y - dy + 1].data(),
+                                        weights[(dx + 1) * 3 + dy + 1].data());
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int x = 1; x <= 15; ++x) {
+            for (int y = 1; y <= 15; ++y) {
+                clipChannels(plane[x][y].data());
+            }
+        }
+    }
+
+    // Second layer and output, one position at a time through a shared buffer.
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                convolveCell(network, first[i], x, y, second[x][y].data());
+                outputs[i][x * 15 + y] = logit(network, second[x][y].data());
+            }
+        }
+    }
+}
+
+PolicyCache::PolicyCache(const size_t &size)
+    : entries(size)
+{}
+
+const PolicyLogits *PolicyCache::probe(const unsigned long long &key) const
+{
+    const auto &entry = entries[key % entries.size()];
+
+    return entry.used && entry.key == key ? &entry.logits : nullptr;
+}
+
+void PolicyCache::insert(const unsigned long long &key, const PolicyLogits &logits)
+{
+    auto &entry = entries[key % entries.size()];
+
+    entry.key = key;
+    entry.used = true;
+    entry.logits = logits;
+}
+
+void PolicyCache::clear()
+{
+    std::fill(entries.begin(), entries.end(), Entry{});
+}
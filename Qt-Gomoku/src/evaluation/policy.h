@@ -0,0 +1,75 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "../core/types.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Evaluation {
+// A small convolutional move policy: own and opponent stone planes, two 3x3 convolutions of
+// POLICY_CHANNELS channels clipped to [0, POLICY_QA], then a 1x1 convolution to one logit per
+// cell. Weights are int16, scaled by POLICY_QA for the first layer and POLICY_QW after.
+inline constexpr int POLICY_CHANNELS = 16;
+inline constexpr int POLICY_QA = 127;
+inline constexpr int POLICY_QW = 64;
+// Logits are returned in 1 / POLICY_LOGIT_SCALE units.
+inline constexpr int POLICY_LOGIT_SCALE = 64;
+
+struct PolicyNetwork
+{
+    // [plane][kernel cell][output channel], plane 0 own stones, kernel cell (dx + 1) * 3 + dy + 1.
+    alignas(32) std::array<std::array<std::array<std::int16_t, POLICY_CHANNELS>, 9>, 2> firstWeights;
+    alignas(32) std::array<std::int16_t, POLICY_CHANNELS> firstBiases;
+    // [kernel cell][input channel pair][output channel][pair member], laid out for madd.
+    alignas(32) std::array<
+        std::array<std::array<std::array<std::int16_t, 2>, POLICY_CHANNELS>, POLICY_CHANNELS / 2>,
+        9> secondWeights;
+    alignas(32) std::array<std::int32_t, POLICY_CHANNELS> secondBiases;
+    alignas(32) std::array<std::int16_t, POLICY_CHANNELS> outputWeights;
+};
+
+using PolicyLogits = std::array<std::int16_t, 225>;
+
+// The position seen by the policy: board[x][y] and the side to move.
+struct PolicyInput
+{
+    std::array<std::array<Stone, 15>, 15> board;
+    Stone stone;
+};
+
+// Binary form: "QTGMKPN1", channel count as a little-endian uint32, then the members in order
+// as little-endian integers. nullptr when the file is missing or doesn't match.
+[[nodiscard]] std::shared_ptr<const PolicyNetwork> loadPolicy(const std::string &path);
+bool savePolicy(const std::string &path, const PolicyNetwork &network);
+
+// Logits of every cell, x * 15 + y, for a batch of positions. Layers run over the whole batch
+// so that each weight block is loaded once per layer.
+void evaluatePolicy(const PolicyNetwork &network,
+                    const std::vector<PolicyInput> &inputs,
+                    std::vector<PolicyLogits> &outputs);
+
+// Direct-mapped cache of logits by position hash.
+class PolicyCache
+{
+private:
+    struct Entry
+    {
+        unsigned long long key = 0;
+        bool used = false;
+        PolicyLogits logits;
+    };
+
+    std::vector<Entry> entries;
+
+public:
+    explicit PolicyCache(const size_t &size = 4096);
+    [[nodiscard]] const PolicyLogits *probe(const unsigned long long &key) const;
+    void insert(const unsigned long long &key, const PolicyLogits &logits);
+    void clear();
+};
+} // namespace Evaluation
+#endif
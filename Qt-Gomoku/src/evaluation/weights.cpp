@@ -0,0 +1,66 @@
+#include "weights.h"
+#include "../core/types.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace Evaluation;
+
+Weights Evaluation::defaultWeights()
+{
+    return {One, Two, Two, Two, Three, Three, Three, Four, Four, Four, Four, Four, OpenFour, Five};
+}
+
+std::optional<Weights> Evaluation::loadWeights(const std::string &path)
+{
+    std::ifstream file(path);
+    auto weights = defaultWeights();
+    std::string line;
+
+    if (!file) {
+        return std::nullopt;
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string shape;
+        int weight = 0;
+
+        if (!(stream >> shape) || shape[0] == '#') {
+            continue;
+        }
+
+        if (!(stream >> weight)) {
+            return std::nullopt;
+        }
+
+        size_t i = 0;
+
+        while (i < SHAPES.size() && shape != SHAPES[i]) {
+            ++i;
+        }
+
+        // Evaluator::evaluate relies on no shape lowering the score of a five.
+        if (i == SHAPES.size() || (i == FIVE_SHAPE && weight != Five) || weight < 0) {
+            return std::nullopt;
+        }
+
+        weights[i] = weight;
+    }
+
+    return weights;
+}
+
+bool Evaluation::saveWeights(const std::string &path, const Weights &weights)
+{
+    std::ofstream file(path);
+
+    file << "# Shape weights, '1' own stone, '2' opponent stone, '0' empty\n";
+
+    for (size_t i = 0; i < SHAPES.size(); ++i) {
+        file << SHAPES[i] << ' ' << weights[i] << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,37 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include <array>
+#include <optional>
+#include <string>
+
+namespace Evaluation {
+// The shapes scored on a line of '0' empty, '1' own and '2' opponent stones.
+inline constexpr std::array<const char *, 14> SHAPES = {"00100",
+                                                        "01010",
+                                                        "00110",
+                                                        "01100",
+                                                        "01110",
+                                                        "010110",
+                                                        "011010",
+                                                        "11110",
+                                                        "01111",
+                                                        "10111",
+                                                        "11011",
+                                                        "11101",
+                                                        "011110",
+                                                        "11111"};
+inline constexpr size_t FIVE_SHAPE = 13;
+
+// Static evaluation weight of every shape. The search thresholds and the move ordering keep
+// using Score, so the five stays at Five for evaluate() to detect a won board, and no weight is
+// negative. Other shapes adding up to Five or more evaluate to Five - 1.
+using Weights = std::array<int, SHAPES.size()>;
+using ShapeCounts = std::array<int, SHAPES.size()>;
+
+[[nodiscard]] Weights defaultWeights();
+// Text form: "<shape> <weight>" lines, '#' starts a comment, missing shapes keep their default.
+[[nodiscard]] std::optional<Weights> loadWeights(const std::string &path);
+bool saveWeights(const std::string &path, const Weights &weights);
+} // namespace Evaluation
+#endif
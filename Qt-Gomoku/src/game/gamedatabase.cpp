@@ -0,0 +1,516 @@
+#include "gamedatabase.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+
+using namespace Game;
+
+namespace {
+constexpr char MAGIC[] = "QTGMKGD1";
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t GAME_SIZE = 16;
+constexpr size_t ENTRY_SIZE = 16;
+constexpr size_t MAX_NAME = 255;
+
+unsigned long long readLittleEndian(const unsigned char *bytes, const size_t &size)
+{
+    unsigned long long value = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        value |= static_cast<unsigned long long>(bytes[i]) << 8 * i;
+    }
+
+    return value;
+}
+
+void writeLittleEndian(unsigned char *bytes, const unsigned long long &value, const size_t &size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> 8 * i & 0xff);
+    }
+}
+
+bool less(const GameIndexEntry &lhs, const GameIndexEntry &rhs)
+{
+    if (lhs.hash != rhs.hash) {
+        return lhs.hash < rhs.hash;
+    }
+
+    return lhs.game != rhs.game ? lhs.game < rhs.game : lhs.ply < rhs.ply;
+}
+
+std::array<unsigned char, ENTRY_SIZE> encode(const GameIndexEntry &entry)
+{
+    std::array<unsigned char, ENTRY_SIZE> bytes{};
+
+    writeLittleEndian(bytes.data(), entry.hash, 8);
+    writeLittleEndian(bytes.data() + 8, entry.game, 4);
+    bytes[12] = entry.ply;
+    bytes[13] = entry.symmetry;
+    bytes[14] = entry.next;
+    bytes[15] = static_cast<unsigned char>(entry.result);
+
+    return bytes;
+}
+
+GameIndexEntry decode(const unsigned char *bytes)
+{
+    return {readLittleEndian(bytes, 8),
+            static_cast<unsigned>(readLittleEndian(bytes + 8, 4)),
+            bytes[12],
+            bytes[13],
+            bytes[14],
+            static_cast<Result>(bytes[15])};
+}
+
+// Encodes the entries in blocks, a write per entry is several times slower.
+bool write(std::ostream &stream, const GameIndexEntry *entries, const size_t &count)
+{
+    std::vector<unsigned char> bytes;
+
+    for (size_t i = 0; i < count; i += 1 << 16) {
+        const auto block = std::min<size_t>(count - i, 1 << 16);
+
+        bytes.resize(block * ENTRY_SIZE);
+
+        for (size_t j = 0; j < block; ++j) {
+            const auto encoded = encode(entries[i + j]);
+
+            std::memcpy(bytes.data() + j * ENTRY_SIZE, encoded.data(), ENTRY_SIZE);
+        }
+
+        stream.write(reinterpret_cast<const char *>(bytes.data()),
+                     static_cast<std::streamsize>(bytes.size()));
+    }
+
+    return static_cast<bool>(stream);
+}
+
+bool read(std::istream &stream, GameIndexEntry &entry)
+{
+    std::array<unsigned char, ENTRY_SIZE> bytes;
+
+    if (!stream.read(reinterpret_cast<char *>(bytes.data()), ENTRY_SIZE)) {
+        return false;
+    }
+
+    entry = decode(bytes.data());
+
+    return true;
+}
+} // namespace
+
+Result Game::gameResult(const std::vector<Point> &moves)
+{
+    if (moves.empty()) {
+        return Result::Unknown;
+    }
+
+    constexpr std::array<Point, 4> directions
+        = {Point{1, 0}, Point{0, 1}, Point{1, 1}, Point{1, -1}};
+    Search::Board board{};
+    auto stone = Black;
+
+    for (const auto &move : moves) {
+        board[move.x][move.y] = stone;
+        stone = static_cast<Stone>(-stone);
+    }
+
+    const auto last = moves.back();
+    const auto winner = board[last.x][last.y];
+
+    for (const auto &direction : directions) {
+        int count = 1;
+
+        for (const auto &sign : {-1, 1}) {
+            for (auto point = last + sign * direction;
+                 point.x >= 0 && point.x < 15 && point.y >= 0 && point.y < 15
+                 && board[point.x][point.y] == winner;
+                 point += sign * direction) {
+                ++count;
+            }
+        }
+
+        if (count >= 5) {
+            return winner == Black ? Result::BlackWin : Result::WhiteWin;
+        }
+    }
+
+    return moves.size() == 225 ? Result::Draw : Result::Unknown;
+}
+
+// The 8 symmetric hashes follow the moves incrementally, the smallest one is the position's key.
+GameBatch Game::indexGames(std::vector<Position> games)
+{
+    GameBatch batch;
+
+    for (size_t game = 0; game < games.size(); ++game) {
+        const auto &moves = games[game].moves;
+        const auto result = gameResult(moves);
+        std::array<unsigned long long, 8> hashes{};
+
+        batch.results.push_back(result);
+
+        for (size_t ply = 0; ply <= moves.size(); ++ply) {
+            GameIndexEntry entry{hashes[0],
+                                 static_cast<unsigned>(game),
+                                 static_cast<unsigned char>(ply),
+                                 0,
+                                 255,
+                                 result};
+
+            for (int symmetry = 1; symmetry < 8; ++symmetry) {
+                if (hashes[symmetry] < entry.hash) {
+                    entry.hash = hashes[symmetry];
+                    entry.symmetry = static_cast<unsigned char>(symmetry);
+                }
+            }
+
+            if (ply < moves.size()) {
+                const auto &move = moves[ply];
+                const auto stone = ply % 2 ? White : Black;
+
+                entry.next = static_cast<unsigned char>(move.x * 15 + move.y);
+
+                for (int symmetry = 0; symmetry < 8; ++symmetry) {
+                    hashes[symmetry] ^= Search::zobristKey(Search::transform(move, symmetry),
+                                                           stone);
+                }
+            }
+
+            batch.index.push_back(entry);
+        }
+    }
+
+    batch.games = std::move(games);
+
+    return batch;
+}
+
+GameDatabaseWriter::GameDatabaseWriter()
+    : runSize(0)
+    , dataSize(0)
+    , gameCount(0)
+    , indexCount(0)
+{}
+
+// Drops the runs of a database left unclosed.
+GameDatabaseWriter::~GameDatabaseWriter()
+{
+    removeRuns();
+}
+
+bool GameDatabaseWriter::open(const std::string &path, const size_t &runSize)
+{
+    removeRuns();
+    file.close();
+    file.clear();
+    file.open(path, std::ios::binary | std::ios::trunc);
+
+    const std::array<char, HEADER_SIZE> header{};
+
+    file.write(header.data(), header.size());
+    this->path = path;
+    this->runSize = std::max<size_t>(runSize, 1);
+    gameTable.clear();
+    run.clear();
+    dataSize = 0;
+    gameCount = 0;
+    indexCount = 0;
+
+    return static_cast<bool>(file);
+}
+
+void GameDatabaseWriter::append(const GameBatch &batch)
+{
+    for (size_t i = 0; i < batch.games.size(); ++i) {
+        const auto &game = batch.games[i];
+        const auto nameLength = std::min(game.name.size(), MAX_NAME);
+        std::vector<unsigned char> data(game.name.begin(), game.name.begin() + nameLength);
+        std::array<unsigned char, GAME_SIZE> bytes{};
+
+        for (const auto &move : game.moves) {
+            data.push_back(static_cast<unsigned char>(move.x * 15 + move.y));
+        }
+
+        writeLittleEndian(bytes.data(), dataSize, 8);
+        writeLittleEndian(bytes.data() + 8, game.moves.size(), 2);
+        bytes[10] = static_cast<unsigned char>(nameLength);
+        bytes[11] = static_cast<unsigned char>(batch.results[i]);
+        gameTable.insert(gameTable.end(), bytes.begin(), bytes.end());
+        file.write(reinterpret_cast<const char *>(data.data()),
+                   static_cast<std::streamsize>(data.size()));
+        dataSize += data.size();
+    }
+
+    for (auto entry : batch.index) {
+        entry.game += static_cast<unsigned>(gameCount);
+        run.push_back(entry);
+
+        if (run.size() >= runSize) {
+            spill();
+        }
+    }
+
+    gameCount += batch.games.size();
+    indexCount += batch.index.size();
+}
+
+// A run that cannot be written fails the database on close.
+void GameDatabaseWriter::spill()
+{
+    const auto runPath = path + ".run" + std::to_string(runs.size());
+    std::ofstream runFile(runPath, std::ios::binary | std::ios::trunc);
+
+    std::sort(run.begin(), run.end(), less);
+    runs.push_back(runPath);
+
+    write(runFile, run.data(), run.size());
+    run.clear();
+
+    if (!runFile.flush()) {
+        file.setstate(std::ios::failbit);
+    }
+}
+
+bool GameDatabaseWriter::close()
+{
+    const auto gamesOffset = HEADER_SIZE + dataSize;
+    const auto indexOffset = gamesOffset + gameTable.size();
+
+    file.write(reinterpret_cast<const char *>(gameTable.data()),
+               static_cast<std::streamsize>(gameTable.size()));
+
+    if (runs.empty()) {
+        std::sort(run.begin(), run.end(), less);
+        write(file, run.data(), run.size());
+    } else {
+        // K-way merge of the sorted runs.
+        if (!run.empty()) {
+            spill();
+        }
+
+        std::vector<std::ifstream> runFiles;
+        std::vector<GameIndexEntry> heads(runs.size());
+        const auto later = [&heads](const size_t &lhs, const size_t &rhs) {
+            return less(heads[rhs], heads[lhs]);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> queue(later);
+        std::vector<GameIndexEntry> merged;
+
+        for (size_t i = 0; i < runs.size(); ++i) {
+            runFiles.emplace_back(runs[i], std::ios::binary);
+
+            if (read(runFiles[i], heads[i])) {
+                queue.push(i);
+            }
+        }
+
+        while (!queue.empty()) {
+            const auto i = queue.top();
+
+            queue.pop();
+            merged.push_back(heads[i]);
+
+            if (read(runFiles[i], heads[i])) {
+                queue.push(i);
+            }
+
+            if (merged.size() == 1 << 16 || queue.empty()) {
+                write(file, merged.data(), merged.size());
+                merged.clear();
+            }
+        }
+    }
+
+    std::array<unsigned char, HEADER_SIZE> header{};
+
+    std::memcpy(header.data(), MAGIC, sizeof(MAGIC) - 1);
+    writeLittleEndian(header.data() + 8, gameCount, 8);
+    writeLittleEndian(header.data() + 16, HEADER_SIZE, 8);
+    writeLittleEndian(header.data() + 24, gamesOffset, 8);
+    writeLittleEndian(header.data() + 32, indexOffset, 8);
+    writeLittleEndian(header.data() + 40, indexCount, 8);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(header.data()), header.size());
+    file.close();
+    removeRuns();
+    run.clear();
+    gameTable.clear();
+
+    return !file.fail();
+}
+
+unsigned long long GameDatabaseWriter::games() const
+{
+    return gameCount;
+}
+
+unsigned long long GameDatabaseWriter::positions() const
+{
+    return indexCount;
+}
+
+void GameDatabaseWriter::removeRuns()
+{
+    for (const auto &runPath : runs) {
+        std::remove(runPath.c_str());
+    }
+
+    runs.clear();
+}
+
+GameDatabase::GameDatabase()
+    : gameCount(0)
+    , indexCount(0)
+    , dataOffset(0)
+    , gamesOffset(0)
+    , indexOffset(0)
+{}
+
+std::shared_ptr<const GameDatabase> GameDatabase::open(const std::string &path)
+{
+    auto database = std::make_shared<GameDatabase>();
+    auto &file = database->file;
+
+    if (!file.open(path) || file.size() < HEADER_SIZE
+        || std::memcmp(file.data(), MAGIC, sizeof(MAGIC) - 1) != 0) {
+        return nullptr;
+    }
+
+    database->gameCount = static_cast<size_t>(readLittleEndian(file.data() + 8, 8));
+    database->dataOffset = static_cast<size_t>(readLittleEndian(file.data() + 16, 8));
+    database->gamesOffset = static_cast<size_t>(readLittleEndian(file.data() + 24, 8));
+    database->indexOffset = static_cast<size_t>(readLittleEndian(file.data() + 32, 8));
+    database->indexCount = static_cast<size_t>(readLittleEndian(file.data() + 40, 8));
+
+    if (database->dataOffset < HEADER_SIZE || database->dataOffset > database->gamesOffset
+        || database->gamesOffset > database->indexOffset
+        || (database->indexOffset - database->gamesOffset) / GAME_SIZE < database->gameCount
+        || database->indexOffset > file.size()
+        || (file.size() - database->indexOffset) / ENTRY_SIZE < database->indexCount) {
+        return nullptr;
+    }
+
+    const auto dataSize = database->gamesOffset - database->dataOffset;
+
+    // Every name and moves within the game data, so that reading a game stays in the file.
+    for (size_t game = 0; game < database->gameCount; ++game) {
+        const auto *bytes = file.data() + database->gamesOffset + game * GAME_SIZE;
+        const auto offset = readLittleEndian(bytes, 8);
+
+        if (offset > dataSize || dataSize - offset < bytes[10] + readLittleEndian(bytes + 8, 2)) {
+            return nullptr;
+        }
+    }
+
+    return database;
+}
+
+size_t GameDatabase::size() const
+{
+    return gameCount;
+}
+
+size_t GameDatabase::positions() const
+{
+    return indexCount;
+}
+
+std::string GameDatabase::name(const unsigned &game) const
+{
+    const auto *bytes = row(game);
+
+    if (!bytes) {
+        return {};
+    }
+
+    const auto *data = file.data() + dataOffset + readLittleEndian(bytes, 8);
+
+    return {reinterpret_cast<const char *>(data), bytes[10]};
+}
+
+std::vector<Point> GameDatabase::moves(const unsigned &game) const
+{
+    const auto *bytes = row(game);
+
+    if (!bytes) {
+        return {};
+    }
+
+    const auto *data = file.data() + dataOffset + readLittleEndian(bytes, 8) + bytes[10];
+    std::vector<Point> moves;
+
+    for (size_t i = 0; i < readLittleEndian(bytes + 8, 2); ++i) {
+        // A move off the board makes the whole game unreadable.
+        if (data[i] >= 225) {
+            return {};
+        }
+
+        moves.push_back({data[i] / 15, data[i] % 15});
+    }
+
+    return moves;
+}
+
+Result GameDatabase::result(const unsigned &game) const
+{
+    const auto *bytes = row(game);
+
+    return bytes ? static_cast<Result>(bytes[11]) : Result::Unknown;
+}
+
+std::vector<GameHit> GameDatabase::find(const Search::Board &board) const
+{
+    // Black's hashes leave the side to move out, as the tables do.
+    const auto [hash, symmetry] = Search::canonicalHash(board, Black);
+    const auto inverse = Search::inverseSymmetry(symmetry);
+    size_t low = 0;
+    size_t high = indexCount;
+    std::vector<GameHit> hits;
+
+    // Lower bound of the hash.
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+
+        if (readLittleEndian(file.data() + indexOffset + middle * ENTRY_SIZE, 8) < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (auto index = low; index < indexCount; ++index) {
+        const auto current = entry(index);
+
+        if (current.hash != hash) {
+            break;
+        }
+
+        GameHit hit{current.game, current.ply, {-1, -1}, current.result};
+
+        // From the game's board to the canonical one, then back to the queried one.
+        if (current.next < 225) {
+            hit.next = Search::transform(
+                Search::transform({current.next / 15, current.next % 15}, current.symmetry),
+                inverse);
+        }
+
+        hits.push_back(hit);
+    }
+
+    return hits;
+}
+
+GameIndexEntry GameDatabase::entry(const size_t &index) const
+{
+    return decode(file.data() + indexOffset + index * ENTRY_SIZE);
+}
+
+const unsigned char *GameDatabase::row(const unsigned &game) const
+{
+    return game < gameCount ? file.data() + gamesOffset + game * GAME_SIZE : nullptr;
+}
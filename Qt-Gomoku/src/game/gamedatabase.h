@@ -0,0 +1,125 @@
+#ifndef GAMEDATABASE_H
+#define GAMEDATABASE_H
+
+#include "../core/mappedfile.h"
+#include "../core/types.h"
+#include "../search/zobrist.h"
+#include "position.h"
+#include "record.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Game {
+// One game that reached a queried position.
+struct GameHit
+{
+    unsigned game = 0;
+    // Moves played before the position.
+    int ply = 0;
+    // The move played from the position on the queried board, {-1, -1} when the game ended.
+    Point next{-1, -1};
+    Result result = Result::Unknown;
+};
+
+// Every position of a game, the empty board included, under its canonical hash without the
+// side to move, which the stone count gives: the key of the transposition tables with
+// canonical hashing, so positions line up with table entries.
+struct GameIndexEntry
+{
+    unsigned long long hash = 0;
+    unsigned game = 0;
+    unsigned char ply = 0;
+    // The symmetry taking the game's board to the canonical one.
+    unsigned char symmetry = 0;
+    // x * 15 + y of the next move on the game's board, 255 when the game ended.
+    unsigned char next = 255;
+    Result result = Result::Unknown;
+};
+
+// Games with their positions hashed, game numbers counting from the first one. Batches are
+// indexed on any thread and appended in order.
+struct GameBatch
+{
+    std::vector<Position> games;
+    std::vector<Result> results;
+    std::vector<GameIndexEntry> index;
+};
+
+// Black or white wins when the last move makes five or more, a full board is a draw.
+[[nodiscard]] Result gameResult(const std::vector<Point> &moves);
+[[nodiscard]] GameBatch indexGames(std::vector<Position> games);
+
+// Writes a game database in one pass over the games, holding the game table and up to runSize
+// index entries in memory. Full runs of entries are sorted and spilled to temporary files
+// next to the database, then merged into the index on close.
+class GameDatabaseWriter
+{
+private:
+    std::string path;
+    std::ofstream file;
+    std::vector<unsigned char> gameTable;
+    std::vector<GameIndexEntry> run;
+    std::vector<std::string> runs;
+    size_t runSize;
+    unsigned long long dataSize;
+    unsigned long long gameCount;
+    unsigned long long indexCount;
+
+public:
+    GameDatabaseWriter();
+    GameDatabaseWriter(const GameDatabaseWriter &) = delete;
+    GameDatabaseWriter &operator=(const GameDatabaseWriter &) = delete;
+    ~GameDatabaseWriter();
+    bool open(const std::string &path, const size_t &runSize);
+    void append(const GameBatch &batch);
+    // The database is valid once close succeeds.
+    bool close();
+    [[nodiscard]] unsigned long long games() const;
+    [[nodiscard]] unsigned long long positions() const;
+
+private:
+    void spill();
+    void removeRuns();
+};
+
+// A game database mapped into memory and searched in place.
+// Binary form, integers little-endian: a 64 bytes header ("QTGMKGD1", then as uint64 the game
+// count and the offsets of the game data, the game table and the index, and the index entry
+// count), the game data (per game its name then one x * 15 + y byte per move), the game table
+// (16 bytes per game: the data offset as uint64, the move count as uint16, the name length and
+// the Result as bytes) and the index (16 bytes per position sorted by hash, game and ply: the
+// hash as uint64, the game as uint32, then the ply, symmetry, next move and Result bytes).
+class GameDatabase
+{
+private:
+    MappedFile file;
+    size_t gameCount;
+    size_t indexCount;
+    size_t dataOffset;
+    size_t gamesOffset;
+    size_t indexOffset;
+
+public:
+    GameDatabase();
+    // nullptr when the file is missing or malformed, a game's name or moves outside its data
+    // included.
+    [[nodiscard]] static std::shared_ptr<const GameDatabase> open(const std::string &path);
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t positions() const;
+    // Empty name and moves and an Unknown result for a game past the last one.
+    [[nodiscard]] std::string name(const unsigned &game) const;
+    [[nodiscard]] std::vector<Point> moves(const unsigned &game) const;
+    [[nodiscard]] Result result(const unsigned &game) const;
+    // The games reaching the position in any symmetry, by game and ply, O(log n) to the first.
+    [[nodiscard]] std::vector<GameHit> find(const Search::Board &board) const;
+
+private:
+    [[nodiscard]] GameIndexEntry entry(const size_t &index) const;
+    // The game table row, nullptr past the last game.
+    [[nodiscard]] const unsigned char *row(const unsigned &game) const;
+};
+} // namespace Game
+#endif
@@ -1,4 +1,5 @@
 #include "movesgenerator.h"
+#include "../core/profiler.h"
 #include "../search/engine.h"
 
 #include <numeric>
@@ -11,18 +12,18 @@ MovesGenerator::MovesGenerator(Evaluation::Evaluator *evaluator,
     , board(board)
 {}
 
-void MovesGenerator::move(const QPoint &point)
+void MovesGenerator::move(const Point &point)
 {
-    history.push(moves);
+    PROFILE_SCOPE(GeneratorMove);
+
+    history.push_back(moves);
 
     for (int i = -3; i <= 3; ++i) {
         for (int j = -3; j <= 3; ++j) {
-            if (const auto neighborhood = point + QPoint(i, j);
+            if (const auto neighborhood = point + Point{i, j};
                 Search::Engine::isLegal(neighborhood)
-                && (*board)[neighborhood.x()][neighborhood.y()] == Empty) {
-                if (!moves.contains(neighborhood)) {
-                    moves.insert(neighborhood, {{0, 0, 0, 0}, {0, 0, 0, 0}});
-                }
+                && (*board)[neighborhood.x][neighborhood.y] == Empty) {
+                moves.try_emplace(neighborhood, std::array<int, 4>{}, std::array<int, 4>{});
             }
         }
     }
@@ -34,8 +35,8 @@ void MovesGenerator::move(const QPoint &point)
     for (size_t i = 0; i < 2; ++i) {
         for (int j = 0; j < 4; ++j) {
             for (int k = 1; k <= 4; ++k) {
-                if (const auto neighborhood = point + k * d[i] * QPoint{dx[j], dy[j]};
-                    moves.contains(neighborhood)) {
+                if (const auto neighborhood = point + k * d[i] * Point{dx[j], dy[j]};
+                    moves.count(neighborhood)) {
                     auto &moveBlackScore = moves[neighborhood].first[j];
                     auto &moveWhiteScore = moves[neighborhood].second[j];
                     const auto [blackScore, whiteScore] = evaluator->evaluateMove(neighborhood, j);
@@ -47,14 +48,16 @@ void MovesGenerator::move(const QPoint &point)
         }
     }
 
-    moves.remove(point);
+    moves.erase(point);
 }
 
-void MovesGenerator::undo(const QPoint &point)
+void MovesGenerator::undo(const Point &)
 {
-    moves = history.top();
+    PROFILE_SCOPE(GeneratorUndo);
 
-    history.pop();
+    moves = history.back();
+
+    history.pop_back();
 }
 
 bool MovesGenerator::empty() const
@@ -62,18 +65,20 @@ bool MovesGenerator::empty() const
     return moves.empty();
 }
 
-QHash<QPoint, QPair<int, int>> MovesGenerator::generate() const
+std::unordered_map<Point, std::pair<int, int>> MovesGenerator::generate() const
 {
-    QHash<QPoint, QPair<int, int>> m;
+    PROFILE_SCOPE(Generate);
+
+    std::unordered_map<Point, std::pair<int, int>> m;
 
     m.reserve(moves.size());
 
-    for (auto it = moves.cbegin(); it != moves.cend(); ++it) {
-        const auto [blackScores, whiteScores] = it.value();
+    for (const auto &[move, scores] : moves) {
+        const auto &[blackScores, whiteScores] = scores;
 
-        m.insert(it.key(),
-                 {std::reduce(blackScores.cbegin(), blackScores.cend()),
-                  std::reduce(whiteScores.cbegin(), whiteScores.cend())});
+        m.emplace(move,
+                  std::pair{std::reduce(blackScores.cbegin(), blackScores.cend()),
+                            std::reduce(whiteScores.cbegin(), whiteScores.cend())});
     }
 
     return m;
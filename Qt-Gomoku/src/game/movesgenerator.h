@@ -3,12 +3,10 @@
 
 #include "../core/types.h"
 
-#include <QHash>
-#include <QPair>
-#include <QPoint>
-#include <QStack>
-
 #include <array>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Evaluation {
 class Evaluator;
@@ -19,17 +17,17 @@ class MovesGenerator
 {
 private:
     Evaluation::Evaluator *evaluator;
-    QStack<QHash<QPoint, QPair<std::array<int, 4>, std::array<int, 4>>>> history;
-    QHash<QPoint, QPair<std::array<int, 4>, std::array<int, 4>>> moves;
+    std::vector<std::unordered_map<Point, std::pair<std::array<int, 4>, std::array<int, 4>>>> history;
+    std::unordered_map<Point, std::pair<std::array<int, 4>, std::array<int, 4>>> moves;
     std::array<std::array<Stone, 15>, 15> *board;
 
 public:
     MovesGenerator() = delete;
     MovesGenerator(Evaluation::Evaluator *evaluator, std::array<std::array<Stone, 15>, 15> *board);
-    void move(const QPoint &point);
-    void undo(const QPoint &point);
+    void move(const Point &point);
+    void undo(const Point &point);
     [[nodiscard]] bool empty() const;
-    [[nodiscard]] QHash<QPoint, QPair<int, int>> generate() const;
+    [[nodiscard]] std::unordered_map<Point, std::pair<int, int>> generate() const;
 };
 } // namespace Game
 #endif
@@ -0,0 +1,103 @@
+#include "position.h"
+#include "../search/engine.h"
+
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+using namespace Game;
+
+// from_chars, since a stream per point made parsing the bulk of importing game archives.
+std::optional<Point> Game::parsePoint(const std::string &text)
+{
+    Point point{-1, -1};
+    const auto *end = text.data() + text.size();
+    const auto x = std::from_chars(text.data(), end, point.x);
+
+    if (x.ec != std::errc() || x.ptr == end || *x.ptr != ',') {
+        return std::nullopt;
+    }
+
+    const auto y = std::from_chars(x.ptr + 1, end, point.y);
+
+    if (y.ec != std::errc() || y.ptr != end || !Search::Engine::isLegal(point)) {
+        return std::nullopt;
+    }
+
+    return point;
+}
+
+std::string Game::toString(const Point &point)
+{
+    return std::to_string(point.x) + ',' + std::to_string(point.y);
+}
+
+std::optional<Position> Game::parsePosition(const std::string &line)
+{
+    Position position;
+    std::string text;
+    std::array<std::array<bool, 15>, 15> occupied{};
+    std::istringstream stream(line);
+
+    if (!(stream >> position.name >> position.category)) {
+        return std::nullopt;
+    }
+
+    while (stream >> text) {
+        const auto point = parsePoint(text);
+
+        if (!point || occupied[point->x][point->y]) {
+            return std::nullopt;
+        }
+
+        occupied[point->x][point->y] = true;
+        position.moves.push_back(*point);
+    }
+
+    return position;
+}
+
+std::optional<std::vector<Position>> Game::loadPositions(const std::string &path)
+{
+    std::ifstream file(path);
+    std::vector<Position> positions;
+    std::string line;
+
+    if (!file) {
+        return std::nullopt;
+    }
+
+    while (std::getline(file, line)) {
+        if (const auto first = line.find_first_not_of(" \t\r");
+            first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        auto position = parsePosition(line);
+
+        if (!position) {
+            return std::nullopt;
+        }
+
+        positions.push_back(std::move(*position));
+    }
+
+    return positions;
+}
+
+Stone Game::sideToMove(const Position &position)
+{
+    return position.moves.size() % 2 ? White : Black;
+}
+
+void Game::setup(Search::Engine &engine, const Position &position)
+{
+    auto stone = Black;
+
+    for (const auto &move : position.moves) {
+        engine.move(move, stone);
+
+        stone = static_cast<Stone>(-stone);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "../core/types.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Search {
+class Engine;
+};
+
+namespace Game {
+// A position is the list of moves played from the empty board, black moves first.
+// Text form: "<name> <category> x,y x,y ...", '#' starts a comment line.
+struct Position
+{
+    std::string name;
+    std::string category;
+    std::vector<Point> moves;
+};
+
+[[nodiscard]] std::optional<Point> parsePoint(const std::string &text);
+[[nodiscard]] std::string toString(const Point &point);
+[[nodiscard]] std::optional<Position> parsePosition(const std::string &line);
+[[nodiscard]] std::optional<std::vector<Position>> loadPositions(const std::string &path);
+[[nodiscard]] Stone sideToMove(const Position &position);
+void setup(Search::Engine &engine, const Position &position);
+} // namespace Game
+#endif
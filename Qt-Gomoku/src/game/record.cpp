@@ -0,0 +1,202 @@
+#include "record.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+
+using namespace Game;
+
+namespace {
+// Occupied cells of every cells byte, a cell is occupied when either of its two bits is set.
+constexpr auto occupiedCounts = [] {
+    std::array<unsigned char, 256> counts{};
+
+    for (int byte = 0; byte < 256; ++byte) {
+        for (int cell = 0; cell < 4; ++cell) {
+            counts[byte] += (byte >> 2 * cell & 3) != 0;
+        }
+    }
+
+    return counts;
+}();
+
+int cellIndex(const Point &point)
+{
+    return point.x * 15 + point.y;
+}
+} // namespace
+
+Stone Record::stone(const Point &point) const
+{
+    const auto cell = cellIndex(point);
+
+    switch (cells[cell / 4] >> 2 * (cell % 4) & 3) {
+    case 1:
+        return Black;
+    case 2:
+        return White;
+    default:
+        return Empty;
+    }
+}
+
+void Record::setStone(const Point &point, const Stone &stone)
+{
+    const auto cell = cellIndex(point);
+    const auto shift = 2 * (cell % 4);
+    const auto value = stone == Black ? 1 : stone == White ? 2 : 0;
+
+    cells[cell / 4] = static_cast<unsigned char>((cells[cell / 4] & ~(3 << shift)) | value << shift);
+}
+
+Stone Record::side() const
+{
+    return sideToMove ? White : Black;
+}
+
+void Record::setSide(const Stone &stone)
+{
+    sideToMove = stone == White;
+}
+
+Point Record::last() const
+{
+    return lastMove < 225 ? Point{lastMove / 15, lastMove % 15} : Point{-1, -1};
+}
+
+void Record::setLast(const Point &point)
+{
+    lastMove = Search::Engine::isLegal(point) ? static_cast<unsigned char>(cellIndex(point)) : 255;
+}
+
+Point Record::best() const
+{
+    return bestMove && bestMove <= 225 ? Point{(bestMove - 1) / 15, (bestMove - 1) % 15}
+                                       : Point{-1, -1};
+}
+
+void Record::setBest(const Point &point)
+{
+    bestMove = Search::Engine::isLegal(point) ? static_cast<unsigned char>(cellIndex(point) + 1)
+                                              : 0;
+}
+
+int Record::scoreValue() const
+{
+    return static_cast<short>(score[0] | score[1] << 8);
+}
+
+void Record::setScore(const int &value)
+{
+    const auto clamped = static_cast<unsigned short>(
+        static_cast<short>(std::max(-32768, std::min(32767, value))));
+
+    score = {static_cast<unsigned char>(clamped & 0xff), static_cast<unsigned char>(clamped >> 8)};
+}
+
+int Record::stoneCount() const
+{
+    int count = 0;
+
+    for (const auto &byte : cells) {
+        count += occupiedCounts[byte];
+    }
+
+    return count;
+}
+
+Record Game::toRecord(const Position &position)
+{
+    Record record;
+    auto stone = Black;
+
+    for (const auto &move : position.moves) {
+        record.setStone(move, stone);
+
+        stone = static_cast<Stone>(-stone);
+    }
+
+    record.setSide(sideToMove(position));
+    record.setLast(position.moves.empty() ? Point{-1, -1} : position.moves.back());
+
+    return record;
+}
+
+Record Game::toRecord(const Search::Engine &engine, const Stone &sideToMove)
+{
+    Record record;
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            record.setStone({x, y}, engine.checkStone({x, y}));
+        }
+    }
+
+    record.setSide(sideToMove);
+    record.setLast(engine.lastMove());
+
+    return record;
+}
+
+std::optional<std::vector<Point>> Game::toMoves(const Record &record)
+{
+    std::vector<Point> blackMoves;
+    std::vector<Point> whiteMoves;
+    const auto last = record.last();
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (const auto stone = record.stone({x, y}); stone != Empty && Point{x, y} != last) {
+                (stone == Black ? blackMoves : whiteMoves).push_back({x, y});
+            }
+        }
+    }
+
+    const auto lastStone = Search::Engine::isLegal(last) ? record.stone(last) : Empty;
+
+    if (lastStone != Empty) {
+        (lastStone == Black ? blackMoves : whiteMoves).push_back(last);
+    }
+
+    // Black moves first, so black has as many stones as white or one more.
+    if (blackMoves.size() != whiteMoves.size() && blackMoves.size() != whiteMoves.size() + 1) {
+        return std::nullopt;
+    }
+
+    // The last move must belong to the side that moved last.
+    if (lastStone != Empty && (lastStone == Black) != (blackMoves.size() > whiteMoves.size())) {
+        return std::nullopt;
+    }
+
+    std::vector<Point> moves;
+
+    moves.reserve(blackMoves.size() + whiteMoves.size());
+
+    for (size_t i = 0; i < blackMoves.size(); ++i) {
+        moves.push_back(blackMoves[i]);
+
+        if (i < whiteMoves.size()) {
+            moves.push_back(whiteMoves[i]);
+        }
+    }
+
+    return moves;
+}
+
+bool Game::setup(Search::Engine &engine, const Record &record)
+{
+    const auto moves = toMoves(record);
+
+    if (!moves) {
+        return false;
+    }
+
+    auto stone = Black;
+
+    for (const auto &move : *moves) {
+        engine.move(move, stone);
+
+        stone = static_cast<Stone>(-stone);
+    }
+
+    return true;
+}
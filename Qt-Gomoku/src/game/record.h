@@ -0,0 +1,58 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "../core/types.h"
+#include "position.h"
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace Search {
+class Engine;
+};
+
+namespace Game {
+enum class Result : unsigned char { Unknown, BlackWin, WhiteWin, Draw };
+
+// A 64 bytes position record. Members are bytes only, so records can be used in place from a
+// memory-mapped file on any alignment and byte order.
+// cells: 2 bits per cell, cell x * 15 + y at bits 2 * (cell % 4) of byte cell / 4,
+//        0 empty, 1 black, 2 white.
+// lastMove: x * 15 + y of the last move, 255 if the board is empty or the order is unknown.
+// score: little-endian int16 from the side to move's point of view.
+// bestMove: x * 15 + y + 1 of the searched best move, 0 if none, so older files read as none.
+struct Record
+{
+    std::array<unsigned char, 57> cells{};
+    unsigned char sideToMove = 0;
+    unsigned char lastMove = 255;
+    Result result = Result::Unknown;
+    std::array<unsigned char, 2> score{};
+    unsigned char bestMove = 0;
+    unsigned char reserved = 0;
+
+    [[nodiscard]] Stone stone(const Point &point) const;
+    void setStone(const Point &point, const Stone &stone);
+    [[nodiscard]] Stone side() const;
+    void setSide(const Stone &stone);
+    [[nodiscard]] Point last() const;
+    void setLast(const Point &point);
+    [[nodiscard]] Point best() const;
+    void setBest(const Point &point);
+    [[nodiscard]] int scoreValue() const;
+    void setScore(const int &value);
+    [[nodiscard]] int stoneCount() const;
+};
+
+static_assert(sizeof(Record) == 64, "Record must stay 64 bytes");
+
+[[nodiscard]] Record toRecord(const Position &position);
+[[nodiscard]] Record toRecord(const Search::Engine &engine, const Stone &sideToMove);
+// A move order reaching the record's board, black first and the last move last.
+// nullopt when no alternating order exists.
+[[nodiscard]] std::optional<std::vector<Point>> toMoves(const Record &record);
+// Plays the record on an empty engine, false if the record is not a reachable position.
+bool setup(Search::Engine &engine, const Record &record);
+} // namespace Game
+#endif
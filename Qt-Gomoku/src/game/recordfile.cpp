@@ -0,0 +1,127 @@
+#include "recordfile.h"
+
+#include <array>
+#include <cstring>
+
+using namespace Game;
+
+namespace {
+constexpr unsigned char VERSION = 1;
+
+std::array<unsigned char, sizeof(Record)> header()
+{
+    std::array<unsigned char, sizeof(Record)> bytes{};
+
+    std::memcpy(bytes.data(), "QTGMKREC", 8);
+    bytes[8] = VERSION;
+    bytes[12] = sizeof(Record);
+
+    return bytes;
+}
+
+bool validHeader(const unsigned char *data, const size_t &length)
+{
+    const auto expected = header();
+
+    return length >= expected.size() && std::memcmp(data, expected.data(), expected.size()) == 0;
+}
+} // namespace
+
+RecordReader::RecordReader()
+    : count(0)
+{}
+
+bool RecordReader::open(const std::string &path)
+{
+    close();
+
+    // Records are mostly scanned in order.
+    if (!file.open(path, true) || !validHeader(file.data(), file.size())) {
+        close();
+
+        return false;
+    }
+
+    // An interrupted append may leave a partial record at the end, it is ignored.
+    count = file.size() / sizeof(Record) - 1;
+
+    return true;
+}
+
+void RecordReader::close()
+{
+    file.close();
+    count = 0;
+}
+
+size_t RecordReader::size() const
+{
+    return count;
+}
+
+const Record &RecordReader::operator[](const size_t &index) const
+{
+    return begin()[index];
+}
+
+const Record *RecordReader::begin() const
+{
+    return file.data() ? reinterpret_cast<const Record *>(file.data() + sizeof(Record)) : nullptr;
+}
+
+const Record *RecordReader::end() const
+{
+    return begin() + count;
+}
+
+bool RecordWriter::open(const std::string &path, const bool &append)
+{
+    file.close();
+
+    if (append) {
+        std::ifstream existing(path, std::ios::binary | std::ios::ate);
+
+        if (existing && existing.tellg() > 0) {
+            std::array<unsigned char, sizeof(Record)> bytes{};
+
+            existing.seekg(0);
+
+            if (!existing.read(reinterpret_cast<char *>(bytes.data()), bytes.size())
+                || !validHeader(bytes.data(), bytes.size())) {
+                return false;
+            }
+
+            // Drop a partial record left by an interrupted write, records must stay aligned.
+            existing.seekg(0, std::ios::end);
+
+            const auto size = static_cast<size_t>(existing.tellg());
+
+            existing.close();
+
+            file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(static_cast<std::streamoff>(size - size % sizeof(Record)));
+
+            return static_cast<bool>(file);
+        }
+    }
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+
+    const auto bytes = header();
+
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+
+    return static_cast<bool>(file);
+}
+
+void RecordWriter::write(const Record &record)
+{
+    file.write(reinterpret_cast<const char *>(&record), sizeof(Record));
+}
+
+bool RecordWriter::close()
+{
+    file.close();
+
+    return !file.fail();
+}
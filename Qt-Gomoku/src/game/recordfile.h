@@ -0,0 +1,44 @@
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include "../core/mappedfile.h"
+#include "record.h"
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+namespace Game {
+// A record file is a 64 bytes header ("QTGMKREC", format version, record size) followed by
+// records, so every record starts at a multiple of 64 and files can be appended to.
+
+// Maps a record file and serves its records in place, without copying or parsing.
+class RecordReader
+{
+private:
+    MappedFile file;
+    size_t count;
+
+public:
+    RecordReader();
+    bool open(const std::string &path);
+    void close();
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] const Record &operator[](const size_t &index) const;
+    [[nodiscard]] const Record *begin() const;
+    [[nodiscard]] const Record *end() const;
+};
+
+class RecordWriter
+{
+private:
+    std::ofstream file;
+
+public:
+    // Writes the header to a new or empty file, or checks it before appending.
+    bool open(const std::string &path, const bool &append = false);
+    void write(const Record &record);
+    bool close();
+};
+} // namespace Game
+#endif
@@ -0,0 +1,65 @@
+#include "selfplay.h"
+
+using namespace Match;
+
+Game::Result Match::play(const Player &black,
+                         const Player &white,
+                         const std::vector<Point> &opening,
+                         std::vector<Point> *moves)
+{
+    auto stone = Black;
+    auto result = Game::Result::Unknown;
+    int step = 0;
+
+    const auto winner = [](const Stone &stone) {
+        return stone == Black ? Game::Result::BlackWin : Game::Result::WhiteWin;
+    };
+
+    while (result == Game::Result::Unknown) {
+        const auto &player = stone == Black ? black : white;
+        const auto point = step < static_cast<int>(opening.size())
+                               ? opening[step]
+                               : player.tree ? player.tree->bestMove(stone, player.limits)
+                                             : player.engine->bestMove(stone, player.limits);
+
+        if (!Search::Engine::isLegal(point) || black.engine->checkStone(point) != Empty) {
+            result = winner(static_cast<Stone>(-stone));
+
+            break;
+        }
+
+        black.engine->move(point, stone);
+        white.engine->move(point, stone);
+
+        for (const auto *player : {&black, &white}) {
+            if (player->tree) {
+                player->tree->move(point, stone);
+            }
+        }
+
+        ++step;
+
+        if (moves) {
+            moves->push_back(point);
+        }
+
+        if (const auto status = black.engine->gameStatus(point, stone); status == Win) {
+            result = winner(stone);
+        } else if (status == Draw) {
+            result = Game::Result::Draw;
+        }
+
+        stone = static_cast<Stone>(-stone);
+    }
+
+    black.engine->undo(step);
+    white.engine->undo(step);
+
+    for (const auto *player : {&black, &white}) {
+        if (player->tree) {
+            player->tree->undo(step);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,28 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include "../core/types.h"
+#include "../game/record.h"
+#include "../search/engine.h"
+#include "../search/mcts.h"
+
+#include <vector>
+
+namespace Match {
+struct Player
+{
+    Search::Engine *engine;
+    Search::Limits limits;
+    // Picks the moves instead of the engine when set, and follows the game as well.
+    Search::MctsEngine *tree = nullptr;
+};
+
+// Plays the opening moves, black first, then lets the players move until gameStatus decides.
+// Both engines must start from the empty board and are taken back to it afterwards.
+// A player returning an illegal move loses. The moves of the game are appended to moves.
+Game::Result play(const Player &black,
+                  const Player &white,
+                  const std::vector<Point> &opening,
+                  std::vector<Point> *moves = nullptr);
+} // namespace Match
+#endif
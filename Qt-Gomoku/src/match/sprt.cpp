@@ -0,0 +1,109 @@
+#include "sprt.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Match;
+
+namespace {
+double eloToScore(const double &elo)
+{
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+double scoreToElo(const double &score)
+{
+    const auto clamped = std::clamp(score, 1e-6, 1 - 1e-6);
+
+    return -400 * std::log10(1 / clamped - 1);
+}
+} // namespace
+
+unsigned long long Tally::games() const
+{
+    return wins + draws + losses;
+}
+
+double Tally::score() const
+{
+    return games() ? (wins + 0.5 * draws) / games() : 0.5;
+}
+
+double Tally::variance() const
+{
+    if (!games()) {
+        return 0;
+    }
+
+    const auto s = score();
+
+    return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+}
+
+double Tally::elo() const
+{
+    return scoreToElo(score());
+}
+
+double Tally::eloError() const
+{
+    if (!games()) {
+        return 0;
+    }
+
+    const auto error = 1.96 * std::sqrt(variance() / games());
+
+    return (scoreToElo(score() + error) - scoreToElo(score() - error)) / 2;
+}
+
+Sprt::Sprt(const double &elo0, const double &elo1, const double &alpha, const double &beta)
+    : elo0(elo0)
+    , elo1(elo1)
+    , lower(std::log(beta / (1 - alpha)))
+    , upper(std::log((1 - beta) / alpha))
+{}
+
+double Sprt::llr(const Tally &tally) const
+{
+    if (!tally.games()) {
+        return 0;
+    }
+
+    auto wins = static_cast<double>(tally.wins);
+    const auto draws = static_cast<double>(tally.draws);
+    auto losses = static_cast<double>(tally.losses);
+
+    // A one-sided match has no variance, half a win and half a loss more give it some, so that
+    // all wins, all draws or all losses still reach a bound.
+    if (tally.variance() <= 0) {
+        wins += 0.5;
+        losses += 0.5;
+    }
+
+    const auto games = wins + draws + losses;
+    const auto score = (wins + 0.5 * draws) / games;
+    const auto variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score)
+                           + losses * score * score)
+                          / games;
+    const auto s0 = eloToScore(elo0);
+    const auto s1 = eloToScore(elo1);
+
+    return games * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+double Sprt::lowerBound() const
+{
+    return lower;
+}
+
+double Sprt::upperBound() const
+{
+    return upper;
+}
+
+Sprt::Decision Sprt::decide(const Tally &tally) const
+{
+    const auto ratio = llr(tally);
+
+    return ratio >= upper ? AcceptH1 : ratio <= lower ? AcceptH0 : Continue;
+}
@@ -0,0 +1,40 @@
+#ifndef SPRT_H
+#define SPRT_H
+
+namespace Match {
+// Game results from the first engine's point of view.
+struct Tally
+{
+    unsigned long long wins = 0;
+    unsigned long long draws = 0;
+    unsigned long long losses = 0;
+
+    [[nodiscard]] unsigned long long games() const;
+    [[nodiscard]] double score() const;
+    [[nodiscard]] double variance() const;
+    [[nodiscard]] double elo() const;
+    // Half width of the 95% confidence interval of elo().
+    [[nodiscard]] double eloError() const;
+};
+
+// Sequential probability ratio test of H0: elo = elo0 against H1: elo = elo1, with the normal
+// approximation of the trinomial log-likelihood ratio used by the usual chess testing tools.
+class Sprt
+{
+private:
+    double elo0;
+    double elo1;
+    double lower;
+    double upper;
+
+public:
+    enum Decision { Continue, AcceptH0, AcceptH1 };
+
+    Sprt(const double &elo0, const double &elo1, const double &alpha, const double &beta);
+    [[nodiscard]] double llr(const Tally &tally) const;
+    [[nodiscard]] double lowerBound() const;
+    [[nodiscard]] double upperBound() const;
+    [[nodiscard]] Decision decide(const Tally &tally) const;
+};
+} // namespace Match
+#endif
@@ -0,0 +1,136 @@
+#include "spsa.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+using namespace Match;
+
+Spsa::Spsa(std::vector<Parameter> parameters,
+           const double &rate,
+           const unsigned long long &iterations)
+    : parameters(std::move(parameters))
+    , rate(rate)
+    , iterations(std::max(1ULL, iterations))
+    , current(0)
+{}
+
+const std::vector<Spsa::Parameter> &Spsa::values() const
+{
+    return parameters;
+}
+
+unsigned long long Spsa::iteration() const
+{
+    return current;
+}
+
+Spsa::Perturbation Spsa::perturb(std::mt19937_64 &random) const
+{
+    const auto scale = std::pow(static_cast<double>(iterations) / (current + 1), 0.101);
+    Perturbation perturbation;
+
+    for (const auto &parameter : parameters) {
+        const auto direction = random() & 1 ? 1 : -1;
+        const auto step = parameter.c * scale * direction;
+
+        perturbation.plus.push_back(std::clamp(parameter.value + step, parameter.min, parameter.max));
+        perturbation.minus.push_back(std::clamp(parameter.value - step, parameter.min, parameter.max));
+        perturbation.directions.push_back(direction);
+    }
+
+    return perturbation;
+}
+
+void Spsa::update(const Perturbation &perturbation, const double &result)
+{
+    const auto stability = iterations / 10.0;
+    const auto cScale = std::pow(static_cast<double>(iterations) / (current + 1), 0.101);
+    const auto rateScale = std::pow((stability + iterations) / (stability + current + 1), 0.602);
+
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        auto &parameter = parameters[i];
+        const auto c = parameter.c * cScale;
+
+        parameter.value = std::clamp(parameter.value
+                                         + rate * rateScale * c * result
+                                               * perturbation.directions[i],
+                                     parameter.min,
+                                     parameter.max);
+    }
+
+    ++current;
+}
+
+bool Spsa::load(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string line;
+
+    if (!file) {
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string name;
+
+        if (!(stream >> name) || name[0] == '#') {
+            continue;
+        }
+
+        if (name == "iteration") {
+            if (!(stream >> current)) {
+                return false;
+            }
+
+            continue;
+        }
+
+        const auto parameter = std::find_if(parameters.begin(),
+                                            parameters.end(),
+                                            [&name](const auto &parameter) {
+                                                return parameter.name == name;
+                                            });
+
+        if (parameter == parameters.end() || !(stream >> parameter->value)) {
+            return false;
+        }
+
+        parameter->value = std::clamp(parameter->value, parameter->min, parameter->max);
+    }
+
+    return true;
+}
+
+bool Spsa::save(const std::string &path) const
+{
+    const auto temporary = path + ".tmp";
+
+    {
+        std::ofstream file(temporary);
+
+        file << "# SPSA checkpoint\niteration " << current << '\n' << std::setprecision(17);
+
+        for (const auto &parameter : parameters) {
+            file << parameter.name << ' ' << parameter.value << '\n';
+        }
+
+        if (!file.flush()) {
+            return false;
+        }
+    }
+
+    // Windows doesn't replace an existing file on rename.
+    if (std::rename(temporary.c_str(), path.c_str()) == 0) {
+        return true;
+    }
+
+    std::remove(path.c_str());
+
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,53 @@
+#ifndef SPSA_H
+#define SPSA_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Match {
+// Simultaneous perturbation stochastic approximation: every iteration plays the parameters
+// moved by +c and -c in random directions against each other and steps towards the winner.
+// c and rate are the values reached at the last iteration, larger before, as in the usual
+// chess engine tuning setups: c_k = c (N / k) ^ 0.101, rate_k = rate ((A + N) / (A + k)) ^ 0.602
+// with A = N / 10.
+class Spsa
+{
+public:
+    struct Parameter
+    {
+        std::string name;
+        double value;
+        double min;
+        double max;
+        double c;
+    };
+
+    struct Perturbation
+    {
+        std::vector<double> plus;
+        std::vector<double> minus;
+        std::vector<int> directions;
+    };
+
+private:
+    std::vector<Parameter> parameters;
+    double rate;
+    unsigned long long iterations;
+    unsigned long long current;
+
+public:
+    Spsa(std::vector<Parameter> parameters, const double &rate, const unsigned long long &iterations);
+    [[nodiscard]] const std::vector<Parameter> &values() const;
+    [[nodiscard]] unsigned long long iteration() const;
+    [[nodiscard]] Perturbation perturb(std::mt19937_64 &random) const;
+    // result is the game points of plus minus those of minus per game, from -1 to 1, so that the
+    // step does not grow with the number of games of an iteration.
+    void update(const Perturbation &perturbation, const double &result);
+    // Text form: "iteration <k>" then "<name> <value>" lines, '#' starts a comment.
+    [[nodiscard]] bool load(const std::string &path);
+    // Written to a temporary file first, an interrupted save keeps the previous checkpoint.
+    bool save(const std::string &path) const;
+};
+} // namespace Match
+#endif
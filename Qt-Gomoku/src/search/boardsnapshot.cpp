@@ -0,0 +1,73 @@
+#include "boardsnapshot.h"
+
+using namespace Search;
+
+PublishedBoard::PublishedBoard()
+    : sequence(0)
+    , cells()
+    , state(0)
+{}
+
+void PublishedBoard::set(const Point &point,
+                         const Stone &stone,
+                         const Point &lastMove,
+                         const int &moves)
+{
+    const auto cell = point.x * 15 + point.y;
+    const auto shift = cell % 32 * 2;
+    auto &word = cells[cell / 32];
+    // Empty, white and black as 0, 1 and 2.
+    const auto code = static_cast<unsigned long long>((stone + 3) % 3);
+    const auto current = sequence.load(std::memory_order_relaxed);
+
+    // An odd sequence marks the write in progress, the fence keeps the stores below after it.
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    word.store((word.load(std::memory_order_relaxed) & ~(3ULL << shift)) | code << shift,
+               std::memory_order_relaxed);
+    state.store((lastMove.x < 0 ? 0ULL : lastMove.x * 15 + lastMove.y + 1ULL)
+                    | static_cast<unsigned long long>(moves) << 8,
+                std::memory_order_relaxed);
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+BoardSnapshot PublishedBoard::read() const
+{
+    std::array<unsigned long long, 8> words{};
+    unsigned long long packed = 0;
+
+    for (;;) {
+        const auto before = sequence.load(std::memory_order_acquire);
+
+        if (before & 1) {
+            continue;
+        }
+
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] = cells[i].load(std::memory_order_relaxed);
+        }
+
+        packed = state.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    BoardSnapshot snapshot;
+
+    for (int cell = 0; cell < 225; ++cell) {
+        const auto code = words[cell / 32] >> cell % 32 * 2 & 3;
+
+        snapshot.board[cell / 15][cell % 15] = code == 2 ? Black : static_cast<Stone>(code);
+    }
+
+    if (const auto last = static_cast<int>(packed & 255)) {
+        snapshot.lastMove = {(last - 1) / 15, (last - 1) % 15};
+    }
+
+    snapshot.moves = static_cast<int>(packed >> 8);
+
+    return snapshot;
+}
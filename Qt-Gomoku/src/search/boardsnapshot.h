@@ -0,0 +1,39 @@
+#ifndef BOARDSNAPSHOT_H
+#define BOARDSNAPSHOT_H
+
+#include "../core/types.h"
+#include "zobrist.h"
+
+#include <array>
+#include <atomic>
+
+namespace Search {
+// A copy of the game position, detached from the engine that published it.
+struct BoardSnapshot
+{
+    Board board{};
+    Point lastMove{-1, -1};
+    int moves = 0;
+};
+
+// The position published by one writer thread and copied by any other without locks: a seqlock
+// over the board packed 2 bits per cell. The writer never waits and updates one cell at a time,
+// a reader retries only when a write overlapped its copy.
+class PublishedBoard
+{
+private:
+    std::atomic<unsigned> sequence;
+    std::array<std::atomic<unsigned long long>, 8> cells;
+    // The last move as x * 15 + y + 1, 0 for none, then the move count from bit 8.
+    std::atomic<unsigned long long> state;
+
+public:
+    PublishedBoard();
+    PublishedBoard(const PublishedBoard &) = delete;
+    PublishedBoard &operator=(const PublishedBoard &) = delete;
+    void set(const Point &point, const Stone &stone, const Point &lastMove, const int &moves);
+    [[nodiscard]] BoardSnapshot read() const;
+};
+} // namespace Search
+
+#endif
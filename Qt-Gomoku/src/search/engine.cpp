@@ -1,23 +1,45 @@
 #include "engine.h"
-
-#include <QTime>
-#include <QtGlobal>
+#include "../core/mappedfile.h"
+#include "../core/profiler.h"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#ifdef GOMOKU_PROFILE
+#include <iostream>
+#endif
 
 using namespace Search;
 
 namespace {
-std::array<int, 226> moveCounts;
-}
+// Snapshot header: magic, format version, entry size and byte order mark, as the tables are
+// stored in their in-memory layout, then the move count.
+constexpr char SNAPSHOT_MAGIC[] = "QTGMKSN1";
+constexpr unsigned SNAPSHOT_VERSION = 2;
+constexpr unsigned BYTE_ORDER_MARK = 0x01020304;
 
-inline bool operator<(const QPoint &lhs, const QPoint &rhs)
+struct SnapshotHeader
+{
+    char magic[8];
+    unsigned version;
+    unsigned entrySize;
+    unsigned byteOrder;
+    unsigned moveCount;
+};
+} // namespace
+
+inline bool operator<(const Point &lhs, const Point &rhs)
 {
     const auto &[lhsX, lhsY] = lhs;
     const auto &[rhsX, rhsY] = rhs;
-    const auto lhsD = qAbs(lhsX - 7) + qAbs(lhsY - 7);
-    const auto rhsD = qAbs(rhsX - 7) + qAbs(rhsY - 7);
+    const auto lhsD = std::abs(lhsX - 7) + std::abs(lhsY - 7);
+    const auto rhsD = std::abs(rhsX - 7) + std::abs(rhsY - 7);
 
     if (lhsD != rhsD) {
         return lhsD < rhsD;
@@ -27,19 +49,40 @@ inline bool operator<(const QPoint &lhs, const QPoint &rhs)
 }
 
 Engine::Engine()
+    : Engine(1 << 29)
+{}
+
+// hashSize is the total size in bytes of the PVS and VCF transposition tables, both hashed with
+// the compile-time ZOBRIST keys: engines search alike from the same state, e.g. after clearHash().
+Engine::Engine(const size_t &hashSize)
+    : Engine(hashSize, ZOBRIST)
+{}
+
+// Tables hashed with keys drawn from seed instead, e.g. to check that results don't hang on
+// the keys.
+Engine::Engine(const size_t &hashSize, const unsigned long long &seed)
+    : Engine(hashSize, makeZobristKeys(seed))
+{}
+
+Engine::Engine(const size_t &hashSize, const ZobristKeys &keys)
     : evaluator(&blackShapes, &whiteShapes)
     , generator(&evaluator, &board)
+    , pvsTT(hashSize / 2, keys)
+    , vcfTT(hashSize / 2, keys)
     , board({})
     , blackShapes({})
     , whiteShapes({})
-    , cutNodeCount(0)
-    , hitNodeCount(0)
     , nodeCount(0)
+    , nodeLimit(0)
+    , probeBase(0)
+    , hitBase(0)
     , ply(0)
+    , rootSymmetries(0)
+    , timeLimited(false)
+    , stopped(false)
+    , searching(false)
 {
-    for (size_t i = 0; i < moveCounts.size(); ++i) {
-        moveCounts[i] = static_cast<int>(std::pow(i, 1.33) + 3) / 2;
-    }
+    setParameters(parameters);
 
     std::fill_n(blackShapes.begin(), 30, std::string(15, '0'));
     std::fill_n(whiteShapes.begin(), 30, std::string(15, '0'));
@@ -56,13 +99,15 @@ Engine::Engine()
     }
 }
 
-bool Engine::isLegal(const QPoint &move)
+bool Engine::isLegal(const Point &move)
 {
-    return move.x() >= 0 && move.x() < 15 && move.y() >= 0 && move.y() < 15;
+    return move.x >= 0 && move.x < 15 && move.y >= 0 && move.y < 15;
 }
 
-void Engine::move(const QPoint &point, const Stone &stone)
+void Engine::move(const Point &point, const Stone &stone)
 {
+    PROFILE_SCOPE(EngineMove);
+
     const auto &[x, y] = point;
     auto &firstShapes = stone == Black ? blackShapes : whiteShapes;
     auto &secondShapes = stone == Black ? whiteShapes : blackShapes;
@@ -72,62 +117,81 @@ void Engine::move(const QPoint &point, const Stone &stone)
     firstShapes[x + 15][y] = '1';
     secondShapes[x + 15][y] = '2';
 
-    if (qAbs(y - x) <= 10) {
-        firstShapes[y - x + 40][qMin(x, y)] = '1';
-        secondShapes[y - x + 40][qMin(x, y)] = '2';
+    if (std::abs(y - x) <= 10) {
+        firstShapes[y - x + 40][std::min(x, y)] = '1';
+        secondShapes[y - x + 40][std::min(x, y)] = '2';
     }
 
     if (x + y >= 4 && x + y <= 24) {
-        firstShapes[x + y + 47][qMin(y, 14 - x)] = '1';
-        secondShapes[x + y + 47][qMin(y, 14 - x)] = '2';
+        firstShapes[x + y + 47][std::min(y, 14 - x)] = '1';
+        secondShapes[x + y + 47][std::min(y, 14 - x)] = '2';
     }
 
     evaluator.update(point);
+
+    if (network) {
+        accumulator.add(point, stone);
+    }
+
     generator.move(point);
     pvsTT.transpose(point, stone);
     vcfTT.transpose(point, stone);
-    moveHistory.push(point);
+    moveHistory.push_back(point);
     board[x][y] = stone;
+
+    if (!searching) {
+        published.set(point, stone, point, static_cast<int>(moveHistory.size()));
+    }
 }
 
 void Engine::undo(const int &step)
 {
+    PROFILE_SCOPE(EngineUndo);
+
     for (int i = 0; i < step; ++i) {
-        const auto move = moveHistory.top();
+        const auto move = moveHistory.back();
         const auto &[x, y] = move;
 
+        if (network) {
+            accumulator.remove(move, checkStone(move));
+        }
+
         generator.undo(move);
         pvsTT.transpose(move, checkStone(move));
         vcfTT.transpose(move, checkStone(move));
-        moveHistory.pop();
+        moveHistory.pop_back();
         board[x][y] = Empty;
         blackShapes[y][x] = '0';
         whiteShapes[y][x] = '0';
         blackShapes[x + 15][y] = '0';
         whiteShapes[x + 15][y] = '0';
 
-        if (qAbs(y - x) <= 10) {
-            blackShapes[y - x + 40][qMin(x, y)] = '0';
-            whiteShapes[y - x + 40][qMin(x, y)] = '0';
+        if (std::abs(y - x) <= 10) {
+            blackShapes[y - x + 40][std::min(x, y)] = '0';
+            whiteShapes[y - x + 40][std::min(x, y)] = '0';
         }
 
         if (x + y >= 4 && x + y <= 24) {
-            blackShapes[x + y + 47][qMin(y, 14 - x)] = '0';
-            whiteShapes[x + y + 47][qMin(y, 14 - x)] = '0';
+            blackShapes[x + y + 47][std::min(y, 14 - x)] = '0';
+            whiteShapes[x + y + 47][std::min(y, 14 - x)] = '0';
         }
 
         evaluator.restore();
+
+        if (!searching) {
+            published.set(move, Empty, lastMove(), static_cast<int>(moveHistory.size()));
+        }
     }
 }
 
-Stone Engine::checkStone(const QPoint &point) const
+Stone Engine::checkStone(const Point &point) const
 {
     const auto &[x, y] = point;
 
     return board[x][y];
 }
 
-Status Engine::gameStatus(const QPoint &move, const Stone &stone) const
+Status Engine::gameStatus(const Point &move, const Stone &stone) const
 {
     constexpr std::array<int, 2> d = {-1, 1};
     constexpr std::array<int, 4> dx = {1, 0, 1, 1};
@@ -137,12 +201,12 @@ Status Engine::gameStatus(const QPoint &move, const Stone &stone) const
         int count = 1;
 
         for (size_t j = 0; j < 2; ++j) {
-            auto neighborhood = move + d[j] * QPoint{dx[i], dy[i]};
+            auto neighborhood = move + d[j] * Point{dx[i], dy[i]};
 
             while (isLegal(neighborhood) && checkStone(neighborhood) == stone) {
                 ++count;
 
-                neighborhood += d[j] * QPoint{dx[i], dy[i]};
+                neighborhood += d[j] * Point{dx[i], dy[i]};
             }
         }
 
@@ -160,55 +224,688 @@ Status Engine::gameStatus(const QPoint &move, const Stone &stone) const
     return Draw;
 }
 
-QPoint Engine::bestMove(const Stone &stone)
+Point Engine::bestMove(const Stone &stone)
+{
+    return bestMove(stone, Limits{});
+}
+
+Point Engine::bestMove(const Stone &stone, const Limits &limits)
 {
+    return search(stone, limits).bestMove;
+}
+
+SearchStats Engine::search(const Stone &stone, const Limits &limits)
+{
+    stats = {};
+
+    // The most played book move, the best scoring one among equals.
+    if (const auto moves = book ? book->probe(board, stone) : std::vector<BookMove>{};
+        !moves.empty()) {
+        stats.bestMove = std::max_element(moves.cbegin(),
+                                          moves.cend(),
+                                          [](const auto &lhs, const auto &rhs) {
+                                              return lhs.games != rhs.games
+                                                         ? lhs.games < rhs.games
+                                                         : lhs.score() < rhs.score();
+                                          })
+                             ->move;
+        stats.pv = {stats.bestMove};
+        stats.bookMove = true;
+
+        return stats;
+    }
+
+    if (const auto solution = solved ? solved->probe(board, stone) : std::nullopt) {
+        stats.bestMove = solution->move;
+        stats.pv = {stats.bestMove};
+        stats.score = solution->result > 0 ? Max - solution->distance : Min + solution->distance;
+        stats.solved = true;
+        stats.proven = true;
+
+        return stats;
+    }
+
     if (const auto last = lastMove();
         moveHistory.empty()
-        || (moveHistory.size() == 1 && last != QPoint(7, 7) && checkStone(last) != stone)) {
-        return {7, 7};
+        || (moveHistory.size() == 1 && last != Point{7, 7} && checkStone(last) != stone)) {
+        stats.bestMove = {7, 7};
+        stats.pv = {stats.bestMove};
+
+        return stats;
+    }
+
+    // Shared tables are left alone, clearing them would wipe the other processes' entries.
+    if (limits.deterministic && !pvsTT.shared()) {
+        clearHash();
     }
 
     pvsTT.aging();
     vcfTT.aging();
+    searching = true;
     ply = static_cast<const int>(moveHistory.size());
+    bestPoint = {-1, -1};
+    startTime = std::chrono::steady_clock::now();
+    reportTime = startTime;
+    deadline = startTime + limits.time;
+    probeBase = pvsTT.probes() + vcfTT.probes();
+    hitBase = pvsTT.hits() + vcfTT.hits();
+    nodeLimit = limits.nodes;
+    progress = limits.progress;
+    timeLimited = limits.time.count() > 0 && !limits.deterministic;
+    stopped = false;
+    rootSymmetries = parameters.rootSymmetry ? boardSymmetries(board) : 0;
+    // No line goes deeper than the empty cells.
+    stats.plyNodes.assign(226 - ply, 0);
+
+    if (policy) {
+        evaluateRootPolicy(stone);
+    }
+
+    if (!timeLimited && !nodeLimit) {
+        stats.score = pvs<PVNode>(stone, Min, Max, limits.depth);
+        stats.depth = limits.depth;
+        stats.iterationNodes.push_back(nodeCount);
+    } else {
+        for (int depth = 1; depth <= limits.depth; ++depth) {
+            const auto iterationStart = nodeCount;
+            const auto score = pvs<PVNode>(stone, Min, Max, depth);
+
+            if (stopped) {
+                break;
+            }
+
+            stats.iterationNodes.push_back(nodeCount - iterationStart);
+
+            stats.bestMove = bestPoint;
+            stats.score = score;
+            stats.depth = depth;
+
+            if (progress) {
+                progress(collectStats());
+            }
+
+            // A loss may come from forward pruning, keep deepening to look for a defence.
+            // The next iteration usually costs more than all previous ones together.
+            if (score >= Max - 225
+                || (timeLimited
+                    && 2 * (std::chrono::steady_clock::now() - startTime) > limits.time)) {
+                break;
+            }
+        }
+    }
+
+    if (!isLegal(bestPoint) && !generator.empty()) {
+        const auto moves = generator.generate();
+
+        bestPoint = std::max_element(moves.cbegin(),
+                                     moves.cend(),
+                                     [](const auto &lhs, const auto &rhs) {
+                                         return lhs.second.first + lhs.second.second
+                                                < rhs.second.first + rhs.second.second;
+                                     })
+                        ->first;
+    }
+
+    stats.bestMove = bestPoint;
+    stats.pv = principalVariation(stone, bestPoint);
+
+    // Only for the solved store, within the limits left to the search.
+    if (solved && stats.score >= Max - 225) {
+        proveWin(stone);
+    }
+
+    collectStats();
+
+#ifdef GOMOKU_PROFILE
+    Profiler::dump(std::clog, stats.time);
+    Profiler::reset();
+#endif
 
-    const QTime time = QTime::currentTime();
-    const auto score = pvs<PVNode>(stone, Min, Max, LIMIT_DEPTH);
-    const auto elapsedTime = time.msecsTo(QTime::currentTime());
-
-    qInfo() << "Best move: " << bestPoint;
-    qInfo() << "Score: " << score;
-    qInfo() << "Node numbers: " << nodeCount;
-    qInfo() << "Cut node numbers: " << cutNodeCount << " (" << 100 * cutNodeCount / nodeCount
-            << "%)";
-    qInfo() << "Hit node numbers: " << hitNodeCount << " (" << 100 * hitNodeCount / nodeCount
-            << "%)";
-    qInfo() << "Elapsed time: " << 0.001 * elapsedTime << 's';
-    qInfo() << "Node per second: " << static_cast<const double>(nodeCount) / (0.001 * elapsedTime);
-    qInfo() << "Time per node: " << 1000.0 * elapsedTime / static_cast<const double>(nodeCount)
-            << "us";
-
-    cutNodeCount = 0;
-    hitNodeCount = 0;
     nodeCount = 0;
+    nodeLimit = 0;
+    progress = nullptr;
+    timeLimited = false;
+
+    if (solved && stats.proven) {
+        storeSolutions(stone);
+    }
+
+    searching = false;
+
+    return stats;
+}
+
+Point Engine::lastMove() const
+{
+    return moveHistory.empty() ? Point{-1, -1} : moveHistory.back();
+}
+
+BoardSnapshot Engine::publishedBoard() const
+{
+    return published.read();
+}
+
+const SearchStats &Engine::searchStats() const
+{
+    return stats;
+}
+
+const Parameters &Engine::searchParameters() const
+{
+    return parameters;
+}
+
+void Engine::setParameters(const Parameters &parameters)
+{
+    this->parameters = parameters;
+
+    for (size_t i = 0; i < moveCounts.size(); ++i) {
+        moveCounts[i] = static_cast<size_t>(std::pow(i, parameters.moveCountExponent) + 3) / 2;
+    }
+
+    pvsTT.setCanonical(parameters.canonicalHash, board);
+    vcfTT.setCanonical(parameters.canonicalHash, board);
+}
+
+void Engine::setWeights(const Evaluation::Weights &weights)
+{
+    evaluator.setWeights(weights);
+}
+
+// Replaces the shape weights at the leaves by the network, or restores them with nullptr.
+void Engine::setNetwork(std::shared_ptr<const Evaluation::Network> network)
+{
+    this->network = std::move(network);
+    accumulator.reset(this->network.get());
+
+    if (this->network) {
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                if (board[x][y] != Empty) {
+                    accumulator.add({x, y}, board[x][y]);
+                }
+            }
+        }
+    }
+}
+
+// Orders and prunes the candidates near the root by the network, or stops with nullptr.
+void Engine::setPolicy(std::shared_ptr<const Evaluation::PolicyNetwork> policy)
+{
+    this->policy = std::move(policy);
+    policyCache.clear();
+}
+
+// A winning open four or the block of a five alone, otherwise all generated moves weighted by
+// the policy when set or by their pattern scores, most likely first.
+std::vector<std::pair<Point, float>> Engine::movePriors(const Stone &stone)
+{
+    if (generator.empty()) {
+        return {};
+    }
+
+    auto moves = generator.generate();
+    std::vector<std::pair<Point, float>> priors;
+
+    inMated(stone, moves);
+
+    const auto firstMaxMove = std::max_element(moves.cbegin(),
+                                               moves.cend(),
+                                               [&stone](const auto &lhs, const auto &rhs) {
+                                                   return (stone == Black ? lhs.second.first
+                                                                          : lhs.second.second)
+                                                          < (stone == Black ? rhs.second.first
+                                                                            : rhs.second.second);
+                                               });
+
+    if ((stone == Black ? firstMaxMove->second.first : firstMaxMove->second.second) >= OpenFour) {
+        return {{firstMaxMove->first, 1.0F}};
+    }
+
+    priors.reserve(moves.size());
+
+    if (policy) {
+        const auto &logits = policyLogits(stone);
+        auto maxLogit = INT_MIN;
+
+        for (const auto &[point, scores] : moves) {
+            maxLogit = std::max(maxLogit, static_cast<int>(logits[point.x * 15 + point.y]));
+        }
+
+        for (const auto &[point, scores] : moves) {
+            priors.emplace_back(point,
+                                static_cast<float>(
+                                    std::exp(static_cast<double>(logits[point.x * 15 + point.y]
+                                                                 - maxLogit)
+                                             / Evaluation::POLICY_LOGIT_SCALE)));
+        }
+    } else {
+        for (const auto &[point, scores] : moves) {
+            priors.emplace_back(point, static_cast<float>(scores.first + scores.second));
+        }
+    }
+
+    float total = 0;
+
+    for (const auto &prior : priors) {
+        total += prior.second;
+    }
+
+    for (auto &prior : priors) {
+        prior.second = total > 0 ? prior.second / total : 1.0F / priors.size();
+    }
+
+    std::sort(priors.begin(), priors.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    });
+
+    return priors;
+}
+
+int Engine::evaluate(const Stone &stone) const
+{
+    const auto firstScore = evaluator.evaluate(stone);
+    const auto secondScore = evaluator.evaluate(static_cast<Stone>(-stone));
+
+    if (firstScore >= Five) {
+        return Max;
+    }
+
+    if (secondScore >= Five) {
+        return Min;
+    }
+
+    return staticEvaluation(stone, firstScore, secondScore);
+}
+
+// Plays from the book while it knows the position, or stops with nullptr.
+void Engine::setBook(std::shared_ptr<const OpeningBook> book)
+{
+    this->book = std::move(book);
+}
+
+// Reads proven results before searching and adds the new ones, or stops with nullptr.
+void Engine::setSolvedStore(std::shared_ptr<SolvedStore> solved)
+{
+    this->solved = std::move(solved);
+}
+
+void Engine::setHashSize(const size_t &hashSize)
+{
+    pvsTT.resize(hashSize / 2);
+    vcfTT.resize(hashSize / 2);
+}
+
+// Keeps private tables of the current size when either segment cannot be shared.
+bool Engine::shareHash(const std::string &name)
+{
+    const auto pvsSize = pvsTT.size();
+    const auto vcfSize = vcfTT.size();
+
+    if (pvsTT.share(name + "-pvs", pvsSize) && vcfTT.share(name + "-vcf", vcfSize)) {
+        return true;
+    }
+
+    pvsTT.resize(pvsSize);
+    vcfTT.resize(vcfSize);
+
+    return false;
+}
+
+void Engine::clearHash()
+{
+    pvsTT.clear();
+    vcfTT.clear();
+    policyCache.clear();
+}
+
+// Streams the header, the moves as x, y and stone bytes, then the pvs and the vcf table.
+bool Engine::saveSnapshot(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    SnapshotHeader header{{},
+                          SNAPSHOT_VERSION,
+                          sizeof(HashEntry),
+                          BYTE_ORDER_MARK,
+                          static_cast<unsigned>(moveHistory.size())};
+
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const auto &point : moveHistory) {
+        const char bytes[] = {static_cast<char>(point.x),
+                              static_cast<char>(point.y),
+                              static_cast<char>(checkStone(point))};
+
+        file.write(bytes, sizeof(bytes));
+    }
+
+    return pvsTT.save(file) && vcfTT.save(file) && file.flush();
+}
+
+// Maps the snapshot and copies the tables out of it, then replays the moves. Snapshots of
+// another version, layout or key set are rejected with the engine unchanged, a truncated one
+// leaves it with empty tables.
+bool Engine::loadSnapshot(const std::string &path)
+{
+    MappedFile file;
+    SnapshotHeader header{};
+
+    if (!file.open(path) || file.size() < sizeof(header)) {
+        return false;
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != SNAPSHOT_VERSION || header.entrySize != sizeof(HashEntry)
+        || header.byteOrder != BYTE_ORDER_MARK || header.moveCount > 225
+        || file.size() < sizeof(header) + 3 * header.moveCount) {
+        return false;
+    }
+
+    const auto *moves = file.data() + sizeof(header);
+    std::vector<std::pair<Point, Stone>> history;
+    Board replay{};
+
+    for (unsigned i = 0; i < header.moveCount; ++i) {
+        const Point point{static_cast<signed char>(moves[3 * i]),
+                          static_cast<signed char>(moves[3 * i + 1])};
+        const auto stone = static_cast<Stone>(static_cast<signed char>(moves[3 * i + 2]));
+
+        if (!isLegal(point) || replay[point.x][point.y] != Empty
+            || (stone != Black && stone != White)) {
+            return false;
+        }
+
+        replay[point.x][point.y] = stone;
+        history.emplace_back(point, stone);
+    }
+
+    const auto *tables = moves + 3 * header.moveCount;
+    const auto remaining = file.size() - sizeof(header) - 3 * header.moveCount;
+    const auto pvsSize = pvsTT.load(tables, remaining);
+    const auto vcfSize = pvsSize ? vcfTT.load(tables + pvsSize, remaining - pvsSize) : 0;
+
+    if (!vcfSize) {
+        // The pvs table may hold the snapshot's entries already.
+        clearHash();
+
+        return false;
+    }
+
+    policyCache.clear();
+    undo(static_cast<int>(moveHistory.size()));
+
+    for (const auto &[point, stone] : history) {
+        move(point, stone);
+    }
+
+    return true;
+}
+
+int Engine::staticEvaluation(const Stone &stone,
+                             const int &firstScore,
+                             const int &secondScore) const
+{
+    return network ? accumulator.evaluate(stone) : firstScore - secondScore;
+}
+
+bool Engine::timeout()
+{
+    if (!stopped && nodeLimit && nodeCount >= nodeLimit) {
+        stopped = true;
+    }
+
+    if (!stopped && (timeLimited || progress) && !(nodeCount & 1023)) {
+        const auto now = std::chrono::steady_clock::now();
+
+        stopped = timeLimited && now >= deadline;
+
+        if (progress && now - reportTime >= std::chrono::milliseconds(100)) {
+            reportTime = now;
+
+            progress(collectStats());
+        }
+    }
+
+    return stopped;
+}
+
+const SearchStats &Engine::collectStats()
+{
+    stats.nodes = nodeCount;
+    stats.ttProbes = pvsTT.probes() + vcfTT.probes() - probeBase;
+    stats.ttHits = pvsTT.hits() + vcfTT.hits() - hitBase;
+    stats.time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime);
+
+    return stats;
+}
+
+unsigned long long Engine::policyKey(const Stone &stone) const
+{
+    return stone == Black ? pvsTT.boardHash() : ~pvsTT.boardHash();
+}
+
+const Evaluation::PolicyLogits &Engine::policyLogits(const Stone &stone)
+{
+    const auto key = policyKey(stone);
+
+    if (const auto *logits = policyCache.probe(key)) {
+        return *logits;
+    }
+
+    std::vector<Evaluation::PolicyLogits> outputs;
+
+    Evaluation::evaluatePolicy(*policy, {{board, stone}}, outputs);
+    policyCache.insert(key, outputs.front());
+
+    return *policyCache.probe(key);
+}
+
+// Fills the cache with the root and every reply in one batch, policyPlies 2 needs no more.
+void Engine::evaluateRootPolicy(const Stone &stone)
+{
+    std::vector<Evaluation::PolicyInput> inputs;
+    std::vector<unsigned long long> keys;
+
+    if (!policyCache.probe(policyKey(stone))) {
+        inputs.push_back({board, stone});
+        keys.push_back(policyKey(stone));
+    }
+
+    for (const auto &[point, scores] : generator.generate()) {
+        move(point, stone);
+
+        if (const auto key = policyKey(static_cast<Stone>(-stone)); !policyCache.probe(key)) {
+            inputs.push_back({board, static_cast<Stone>(-stone)});
+            keys.push_back(key);
+        }
+
+        undo(1);
+    }
+
+    std::vector<Evaluation::PolicyLogits> outputs;
+
+    Evaluation::evaluatePolicy(*policy, inputs, outputs);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        policyCache.insert(keys[i], outputs[i]);
+    }
+}
+
+// Rescores the candidates by logit below the table move and the moves making or stopping a
+// three or four, then drops the unlikely ones. The most likely move always stays.
+void Engine::applyPolicy(const Stone &stone,
+                         const std::unordered_map<Point, std::pair<int, int>> &moves,
+                         std::vector<std::pair<int, Point>> &candidates)
+{
+    const auto &logits = policyLogits(stone);
+    const auto logitOf = [&logits](const Point &point) {
+        return static_cast<int>(logits[point.x * 15 + point.y]);
+    };
+    const auto best = std::max_element(candidates.cbegin(),
+                                       candidates.cend(),
+                                       [&logitOf](const auto &lhs, const auto &rhs) {
+                                           return logitOf(lhs.second) < logitOf(rhs.second);
+                                       })
+                          ->second;
+    double total = 0;
+
+    for (const auto &candidate : candidates) {
+        total += std::exp(static_cast<double>(logitOf(candidate.second) - logitOf(best))
+                          / Evaluation::POLICY_LOGIT_SCALE);
+    }
+
+    auto it = candidates.begin();
+
+    while (it != candidates.end()) {
+        const auto &[blackScore, whiteScore] = moves.at(it->second);
+        const auto prior = std::exp(static_cast<double>(logitOf(it->second) - logitOf(best))
+                                    / Evaluation::POLICY_LOGIT_SCALE)
+                           / total;
+
+        if (it->first == INT_MAX) {
+            ++it;
+        } else if (std::max(blackScore, whiteScore) >= Four) {
+            it->first += INT_MAX / 2;
+            ++it;
+        } else if (prior < parameters.policyPrune && it->second != best) {
+            ++stats.policyPrunes;
+            it = candidates.erase(it);
+        } else {
+            it->first = logitOf(it->second);
+            ++it;
+        }
+    }
+}
+
+// Keeps the first of the candidates that the root board symmetries map onto each other, they
+// lead to mirrored positions of equal value.
+void Engine::removeSymmetricMoves(std::vector<std::pair<int, Point>> &candidates)
+{
+    std::array<bool, 225> seen{};
+    auto it = candidates.begin();
+
+    while (it != candidates.end()) {
+        auto representative = it->second.x * 15 + it->second.y;
 
-    return bestPoint;
+        for (int symmetry = 1; symmetry < 8; ++symmetry) {
+            if (rootSymmetries >> symmetry & 1) {
+                const auto image = transform(it->second, symmetry);
+
+                representative = std::min(representative, image.x * 15 + image.y);
+            }
+        }
+
+        if (seen[representative]) {
+            ++stats.symmetryPrunes;
+            it = candidates.erase(it);
+        } else {
+            seen[representative] = true;
+            ++it;
+        }
+    }
 }
 
-QPoint Engine::lastMove() const
+// Follows the pvs table moves from the root until a move is missing, illegal or ends the game.
+std::vector<Point> Engine::principalVariation(const Stone &stone, const Point &firstMove)
 {
-    return moveHistory.empty() ? QPoint(-1, -1) : moveHistory.top();
+    std::vector<Point> pv;
+    auto point = firstMove;
+
+    for (auto side = stone; isLegal(point) && checkStone(point) == Empty;
+         side = static_cast<Stone>(-side)) {
+        move(point, side);
+        pv.push_back(point);
+
+        if (gameStatus(point, side) != Undecided || pv.size() >= 225) {
+            break;
+        }
+
+        point = pvsTT.probeMove(pvsTT.hash(), static_cast<Stone>(-side));
+    }
+
+    undo(static_cast<int>(pv.size()));
+
+    return pv;
 }
 
-bool Engine::inMated(const Stone &stone, QHash<QPoint, QPair<int, int>> &moves)
+// Forward pruning may cut the defence, so a win of the pruned search is only taken as proven
+// when the VCF search finds it too: there every reply to a four is the forced block. A proven win
+// replaces the result with the VCF line, the statistics keep counting the search alone.
+void Engine::proveWin(const Stone &stone)
+{
+    const auto searched = stats;
+    std::vector<Point> line;
+
+    stopped = false;
+
+    const auto score = vcfSearch<PVNode>(stone, Min, Max, VCF_DEPTH);
+
+    // A proof cut short by the limits proves nothing.
+    auto point = score >= Max - 225 && !stopped ? vcfTT.probeMove(vcfTT.hash(), stone)
+                                                : Point{-1, -1};
+
+    for (auto side = stone; isLegal(point) && checkStone(point) == Empty;
+         side = static_cast<Stone>(-side)) {
+        move(point, side);
+        line.push_back(point);
+
+        if (gameStatus(point, side) != Undecided) {
+            break;
+        }
+
+        point = vcfTT.probeMove(vcfTT.hash(), static_cast<Stone>(-side));
+    }
+
+    undo(static_cast<int>(line.size()));
+
+    stats = searched;
+
+    if (!line.empty()) {
+        stats.score = score;
+        stats.bestMove = line.front();
+        stats.pv = std::move(line);
+        stats.proven = true;
+    }
+}
+
+// Stores the proven root result and the results along the principal variation, every ply
+// swaps the result and brings the five one ply closer.
+void Engine::storeSolutions(const Stone &stone)
+{
+    auto side = stone;
+    auto result = stats.score > 0 ? 1 : -1;
+    auto distance = stats.score > 0 ? Max - stats.score : stats.score - Min;
+    int played = 0;
+
+    for (const auto &point : stats.pv) {
+        if (distance <= 0 || !isLegal(point) || checkStone(point) != Empty) {
+            break;
+        }
+
+        solved->store(board, side, {result, point, distance});
+        move(point, side);
+        ++played;
+        side = static_cast<Stone>(-side);
+        result = -result;
+        --distance;
+    }
+
+    undo(played);
+}
+
+bool Engine::inMated(const Stone &stone, std::unordered_map<Point, std::pair<int, int>> &moves)
 {
     auto blackMaxMove = moves.cbegin();
     auto whiteMaxMove = moves.cbegin();
 
     for (auto it = moves.cbegin(); it != moves.cend(); ++it) {
-        const auto [blackScore, whiteScore] = it.value();
-        const auto &blackMaxScore = blackMaxMove.value().first;
-        const auto &whiteMaxScore = whiteMaxMove.value().second;
+        const auto [blackScore, whiteScore] = it->second;
+        const auto &blackMaxScore = blackMaxMove->second.first;
+        const auto &whiteMaxScore = whiteMaxMove->second.second;
 
         if (blackScore > blackMaxScore) {
             blackMaxMove = it;
@@ -219,8 +916,8 @@ bool Engine::inMated(const Stone &stone, QHash<QPoint, QPair<int, int>> &moves)
         }
     }
 
-    const auto &blackMaxScore = blackMaxMove.value().first;
-    const auto &whiteMaxScore = whiteMaxMove.value().second;
+    const auto &blackMaxScore = blackMaxMove->second.first;
+    const auto &whiteMaxScore = whiteMaxMove->second.second;
     const auto &firstMaxScore = stone == Black ? blackMaxScore : whiteMaxScore;
 
     if (firstMaxScore >= Five) {
@@ -231,11 +928,11 @@ bool Engine::inMated(const Stone &stone, QHash<QPoint, QPair<int, int>> &moves)
     const auto &secondMaxScore = stone == Black ? whiteMaxScore : blackMaxScore;
 
     if (secondMaxScore >= Five) {
-        const auto move = secondMaxMove.key();
-        const auto scores = secondMaxMove.value();
+        const auto move = secondMaxMove->first;
+        const auto scores = secondMaxMove->second;
 
         moves.clear();
-        moves.insert(move, scores);
+        moves.emplace(move, scores);
 
         return true;
     }
@@ -247,8 +944,16 @@ template<NodeType NT>
 int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth, const bool &nullOk)
 {
     ++nodeCount;
+    ++stats.pvsNodes;
+
+    if (timeout()) {
+        return 0;
+    }
 
     const int distance = static_cast<const int>(moveHistory.size()) - ply;
+
+    ++stats.plyNodes[distance];
+    stats.seldepth = std::max(stats.seldepth, distance);
     const auto firstScore = evaluator.evaluate(stone);
     const auto secondScore = evaluator.evaluate(static_cast<const Stone>(-stone));
 
@@ -268,38 +973,40 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
         return vcfSearch<NT>(stone, alpha, beta, VCF_DEPTH);
     }
 
-    QPoint heuristicMove{-1, -1};
+    Point heuristicMove{-1, -1};
     auto moves = generator.generate();
     const auto extension = inMated(stone, moves);
     auto probeScore = pvsTT.probe(pvsTT.hash(), alpha, beta, depth, stone, heuristicMove);
 
     if (!distance && moves.size() == 1) {
-        bestPoint = moves.cbegin().key();
+        bestPoint = moves.cbegin()->first;
 
         return vcfSearch<PVNode>(stone, alpha, beta, VCF_DEPTH);
     }
 
     if (NT != PVNode) {
         if (probeScore != MISS) {
-            ++hitNodeCount;
+            ++stats.ttCutoffs;
 
             return probeScore;
         }
 
-        const auto eval = firstScore - secondScore;
+        const auto eval = staticEvaluation(stone, firstScore, secondScore);
+
+        if (depth < 3 && eval + parameters.futilityMargin * depth < alpha) {
+            ++stats.futilityCutoffs;
 
-        if (depth < 3 && eval + Two * depth < alpha) {
             return vcfSearch<NT>(stone, alpha, alpha + 1, VCF_DEPTH);
         }
 
-        if (eval - Two * depth >= beta) {
-            ++cutNodeCount;
+        if (eval - parameters.futilityMargin * depth >= beta) {
+            ++stats.futilityCutoffs;
 
             return beta;
         }
 
         if (!extension && nullOk) {
-            R = depth >= 6 ? 3 : 2;
+            const auto R = parameters.nullMoveR + (depth >= parameters.nullMoveDepth);
 
             auto score = -pvs<NT>(static_cast<const Stone>(-stone),
                                   -beta,
@@ -307,6 +1014,10 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
                                   depth - R - 1,
                                   false);
 
+            if (stopped) {
+                return 0;
+            }
+
             if (score >= Max - 225) {
                 --score;
             } else if (score <= Min + 225) {
@@ -314,23 +1025,23 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
             }
 
             if (score >= beta) {
-                ++cutNodeCount;
+                ++stats.nullMoveCutoffs;
 
                 return beta;
             }
         }
     }
 
-    QList<QPair<int, QPoint>> candidates;
+    std::vector<std::pair<int, Point>> candidates;
     auto blackMaxMove = moves.cbegin();
     auto whiteMaxMove = moves.cbegin();
 
     candidates.reserve(moves.size());
 
     for (auto it = moves.cbegin(); it != moves.cend(); ++it) {
-        const auto [blackScore, whiteScore] = it.value();
-        const auto &blackMaxScore = blackMaxMove.value().first;
-        const auto &whiteMaxScore = whiteMaxMove.value().second;
+        const auto [blackScore, whiteScore] = it->second;
+        const auto &blackMaxScore = blackMaxMove->second.first;
+        const auto &whiteMaxScore = whiteMaxMove->second.second;
 
         if (blackScore > blackMaxScore) {
             blackMaxMove = it;
@@ -340,7 +1051,7 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
             whiteMaxMove = it;
         }
 
-        candidates.emplace_back(blackScore + whiteScore, it.key());
+        candidates.emplace_back(blackScore + whiteScore, it->first);
     }
 
     bool mated = false;
@@ -348,22 +1059,24 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
     if (!extension) {
         const auto &firstMaxMove = stone == Black ? blackMaxMove : whiteMaxMove;
         const auto &secondMaxMove = stone == Black ? whiteMaxMove : blackMaxMove;
-        const auto &blackMaxScore = blackMaxMove.value().first;
-        const auto &whiteMaxScore = whiteMaxMove.value().second;
+        const auto &blackMaxScore = blackMaxMove->second.first;
+        const auto &whiteMaxScore = whiteMaxMove->second.second;
         const auto &firstMaxScore = stone == Black ? blackMaxScore : whiteMaxScore;
         const auto &secondMaxScore = stone == Black ? whiteMaxScore : blackMaxScore;
 
         if (firstMaxScore >= OpenFour) {
             candidates.clear();
-            candidates.emplace_back(firstMaxMove.value().first + firstMaxMove.value().second,
-                                    firstMaxMove.key());
+            candidates.emplace_back(firstMaxMove->second.first + firstMaxMove->second.second,
+                                    firstMaxMove->first);
         } else if (secondMaxScore >= OpenFour) {
+            PROFILE_SCOPE(MatedFilter);
+
             mated = true;
 
             int d;
 
             for (d = 0; d < 4; ++d) {
-                const auto [blackScore, whiteScore] = evaluator.evaluateMove(secondMaxMove.key(), d);
+                const auto [blackScore, whiteScore] = evaluator.evaluateMove(secondMaxMove->first, d);
 
                 if (const auto &secondMoveScore = stone == Black ? whiteScore : blackScore;
                     secondMoveScore >= OpenFour) {
@@ -371,14 +1084,14 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
                 }
             }
 
-            const auto line = Evaluation::Evaluator::lineOffsetPair(secondMaxMove.key(), d).first;
+            const auto line = Evaluation::Evaluator::lineOffsetPair(secondMaxMove->first, d).first;
             auto it = candidates.cbegin();
 
             while (it != candidates.cend()) {
                 const auto &[blackScore, whiteScore] = moves[it->second];
                 const auto &firstMoveScore = stone == Black ? blackScore : whiteScore;
-                const auto [x, y] = secondMaxMove.key() - it->second;
-                const auto offset = qAbs(qMax(x, y));
+                const auto [x, y] = secondMaxMove->first - it->second;
+                const auto offset = std::abs(std::max(x, y));
 
                 if (offset <= 5 && Evaluation::Evaluator::lineOffsetPair(it->second, d).first == line
                     || firstMoveScore >= Four && evaluator.isFourMove(it->second, stone)) {
@@ -396,28 +1109,43 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
                                          });
             it != candidates.cend()) {
             candidates.erase(it);
-            candidates.emplaceFront(INT_MAX, heuristicMove);
+            candidates.emplace(candidates.cbegin(), INT_MAX, heuristicMove);
         }
     }
 
-    std::sort(candidates.begin(), candidates.end(), std::greater());
+    if (policy && !extension && !mated && distance < parameters.policyPlies
+        && candidates.size() > 1) {
+        applyPolicy(stone, moves, candidates);
+    }
+
+    {
+        PROFILE_SCOPE(CandidateSort);
 
-    if (NT == CutNode && depth > MC_R && candidates.size() >= MC_M) {
+        std::sort(candidates.begin(), candidates.end(), std::greater());
+    }
+
+    if (NT == CutNode && depth > parameters.multiCutR
+        && candidates.size() >= static_cast<size_t>(parameters.multiCutM)) {
         int c = 0;
         int m = 0;
         auto it = candidates.cbegin();
-        QList<QPair<int, QPoint>> cutoffs;
+        std::vector<std::pair<int, Point>> cutoffs;
 
-        while (m < MC_M) {
+        while (m < parameters.multiCutM) {
             move(it->second, stone);
 
             auto score = -pvs<static_cast<const NodeType>(-NT)>(static_cast<const Stone>(-stone),
                                                                 -beta,
                                                                 -alpha,
-                                                                depth - MC_R - 1);
+                                                                depth - parameters.multiCutR
+                                                                    - 1);
 
             undo(1);
 
+            if (stopped) {
+                return 0;
+            }
+
             if (score >= Max - 225) {
                 --score;
             } else if (score <= Min + 225) {
@@ -426,13 +1154,13 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
 
             if (score >= beta) {
                 if (score >= Five) {
-                    ++cutNodeCount;
+                    ++stats.multiCutCutoffs;
 
                     return score;
                 }
 
-                if (++c >= MC_C) {
-                    ++cutNodeCount;
+                if (++c >= parameters.multiCutC) {
+                    ++stats.multiCutCutoffs;
 
                     return beta;
                 }
@@ -448,7 +1176,7 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
         }
 
         if (!cutoffs.empty()) {
-            candidates = cutoffs + candidates;
+            candidates.insert(candidates.cbegin(), cutoffs.cbegin(), cutoffs.cend());
         }
     }
 
@@ -456,6 +1184,11 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
         candidates.resize(moveCounts[depth]);
     }
 
+    // After the move count limit, so that the pruned images leave the other moves as they were.
+    if (!distance && rootSymmetries) {
+        removeSymmetricMoves(candidates);
+    }
+
     move(candidates.front().second, stone);
 
     auto bestScore = -pvs<static_cast<const NodeType>(-NT)>(static_cast<const Stone>(-stone),
@@ -465,6 +1198,10 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
 
     undo(1);
 
+    if (stopped) {
+        return 0;
+    }
+
     if (bestScore >= Max - 225) {
         --bestScore;
     } else if (bestScore <= Min + 225) {
@@ -478,12 +1215,13 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
                      depth,
                      bestScore,
                      stone);
-        ++cutNodeCount;
+        ++stats.betaCutoffs;
+        ++stats.cutoffIndices[0];
 
         return bestScore;
     }
 
-    QPoint pvNode{-1, -1};
+    Point pvNode{-1, -1};
     auto valueType = HashEntry::UpperBound;
 
     if (bestScore > alpha) {
@@ -496,9 +1234,13 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
         }
     }
 
-    candidates.pop_front();
+    candidates.erase(candidates.cbegin());
+
+    size_t index = 0;
 
     for (const auto [_, candidate] : candidates) {
+        ++index;
+
         move(candidate, stone);
 
         auto candidateScore = -pvs < NT == CutNode ? AllNode
@@ -509,6 +1251,10 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
 
         undo(1);
 
+        if (stopped) {
+            return 0;
+        }
+
         if (candidateScore >= Max - 225) {
             --candidateScore;
         } else if (candidateScore <= Min + 225) {
@@ -530,6 +1276,10 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
 
             undo(1);
 
+            if (stopped) {
+                return 0;
+            }
+
             if (candidateScore >= Max - 225) {
                 --candidateScore;
             } else if (candidateScore <= Min + 225) {
@@ -542,7 +1292,8 @@ int Engine::pvs(const Stone &stone, int alpha, const int &beta, const int &depth
 
             if (bestScore >= beta) {
                 pvsTT.insert(pvsTT.hash(), HashEntry::LowerBound, candidate, depth, bestScore, stone);
-                ++cutNodeCount;
+                ++stats.betaCutoffs;
+                ++stats.cutoffIndices[std::min(index, stats.cutoffIndices.size() - 1)];
 
                 return bestScore;
             }
@@ -572,6 +1323,13 @@ template<NodeType NT>
 int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int &depth)
 {
     ++nodeCount;
+    ++stats.vcfNodes;
+
+    if (timeout()) {
+        return 0;
+    }
+
+    stats.seldepth = std::max(stats.seldepth, static_cast<int>(moveHistory.size()) - ply);
 
     const auto firstScore = evaluator.evaluate(stone);
     const auto secondScore = evaluator.evaluate(static_cast<const Stone>(-stone));
@@ -588,49 +1346,49 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
         return 0;
     }
 
-    const auto eval = firstScore - secondScore;
+    const auto eval = staticEvaluation(stone, firstScore, secondScore);
 
     if (!depth) {
         return eval;
     }
 
-    QPoint heuristicMove{-1, -1};
+    Point heuristicMove{-1, -1};
     const auto probeScore = vcfTT.probe(vcfTT.hash(), alpha, beta, depth, stone, heuristicMove);
 
     if (NT != PVNode && probeScore != MISS) {
-        ++hitNodeCount;
+        ++stats.ttCutoffs;
 
         return probeScore;
     }
 
     if (eval >= beta) {
         vcfTT.insert(vcfTT.hash(), HashEntry::LowerBound, {-1, -1}, depth, eval, stone);
-        ++cutNodeCount;
+        ++stats.vcfCutoffs;
 
         return eval;
     }
 
     auto moves = generator.generate();
     const auto extension = inMated(stone, moves);
-    QList<QPair<int, QPoint>> candidates;
+    std::vector<std::pair<int, Point>> candidates;
 
     candidates.reserve(moves.size());
 
     if (extension) {
         const auto it = moves.cbegin();
-        const auto [blackScore, whiteScore] = it.value();
+        const auto [blackScore, whiteScore] = it->second;
 
-        candidates.emplace_back(blackScore + whiteScore, it.key());
+        candidates.emplace_back(blackScore + whiteScore, it->first);
     } else {
         bool mate = false;
 
         for (auto it = moves.cbegin(); it != moves.cend(); ++it) {
-            const auto [blackScore, whiteScore] = it.value();
+            const auto [blackScore, whiteScore] = it->second;
             const auto firstMoveScore = stone == Black ? blackScore : whiteScore;
 
             if (firstMoveScore >= Five) {
                 candidates.clear();
-                candidates.emplace_back(blackScore + whiteScore, it.key());
+                candidates.emplace_back(blackScore + whiteScore, it->first);
 
                 break;
             }
@@ -639,9 +1397,9 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
                 mate = true;
 
                 candidates.clear();
-                candidates.emplace_back(blackScore + whiteScore, it.key());
-            } else if (!mate && firstMoveScore >= Four && evaluator.isFourMove(it.key(), stone)) {
-                candidates.emplace_back(blackScore + whiteScore, it.key());
+                candidates.emplace_back(blackScore + whiteScore, it->first);
+            } else if (!mate && firstMoveScore >= Four && evaluator.isFourMove(it->first, stone)) {
+                candidates.emplace_back(blackScore + whiteScore, it->first);
             }
         }
 
@@ -652,7 +1410,7 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
                                          });
             it != candidates.cend()) {
             candidates.erase(it);
-            candidates.emplaceFront(INT_MAX, heuristicMove);
+            candidates.emplace(candidates.cbegin(), INT_MAX, heuristicMove);
         }
 
         if (candidates.empty()) {
@@ -671,13 +1429,17 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
 
     undo(1);
 
+    if (stopped) {
+        return 0;
+    }
+
     if (bestScore >= Max - 225) {
         --bestScore;
     } else if (bestScore <= Min + 225) {
         ++bestScore;
     }
 
-    QPoint pvNode{-1, -1};
+    Point pvNode{-1, -1};
     auto valueType = HashEntry::UpperBound;
 
     if (bestScore >= beta) {
@@ -687,7 +1449,7 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
                      depth,
                      bestScore,
                      stone);
-        ++cutNodeCount;
+        ++stats.vcfCutoffs;
 
         return bestScore;
     }
@@ -698,7 +1460,7 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
         valueType = HashEntry::Exact;
     }
 
-    candidates.pop_front();
+    candidates.erase(candidates.cbegin());
 
     for (const auto [_, candidate] : candidates) {
         move(candidate, stone);
@@ -712,6 +1474,10 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
 
         undo(1);
 
+        if (stopped) {
+            return 0;
+        }
+
         if (candidateScore >= Max - 225) {
             --candidateScore;
         } else if (candidateScore <= Min + 225) {
@@ -729,6 +1495,10 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
 
             undo(1);
 
+            if (stopped) {
+                return 0;
+            }
+
             if (candidateScore >= Max - 225) {
                 --candidateScore;
             } else if (candidateScore <= Min + 225) {
@@ -741,7 +1511,7 @@ int Engine::vcfSearch(const Stone &stone, int alpha, const int &beta, const int
 
             if (bestScore >= beta) {
                 vcfTT.insert(vcfTT.hash(), HashEntry::LowerBound, candidate, depth, bestScore, stone);
-                ++cutNodeCount;
+                ++stats.vcfCutoffs;
 
                 return bestScore;
             }
@@ -3,55 +3,165 @@
 
 #include "../core/types.h"
 #include "../evaluation/evaluator.h"
+#include "../evaluation/nnue.h"
+#include "../evaluation/policy.h"
 #include "../game/movesgenerator.h"
+#include "boardsnapshot.h"
+#include "openingbook.h"
+#include "searchstats.h"
+#include "solvedstore.h"
 #include "transpositiontable.h"
 
-#include <QPair>
-#include <QPoint>
-#include <QStack>
-
 #include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Search {
 inline int LIMIT_DEPTH = 12;
 inline int MC_C = 3;
 inline int MC_M = 10;
 inline int MC_R = 3;
-inline int R = 3;
 inline int VCF_DEPTH = 225;
 
 enum NodeType { AllNode = -1, PVNode, CutNode };
 
+// Search settings of one engine, taken from the globals above when not set.
+struct Parameters
+{
+    int multiCutC = MC_C;
+    int multiCutM = MC_M;
+    int multiCutR = MC_R;
+    // Null move reduction, one more from nullMoveDepth remaining plies on.
+    int nullMoveR = 2;
+    int nullMoveDepth = 6;
+    // Futility margin per remaining ply.
+    int futilityMargin = Two;
+    // Candidates searched at depth d: (d ^ moveCountExponent + 3) / 2.
+    double moveCountExponent = 1.33;
+    // With a policy network, candidates up to policyPlies from the root are ordered by its
+    // logits, and those with a prior below policyPrune dropped unless they make or stop a four.
+    int policyPlies = 2;
+    double policyPrune = 0.002;
+    // Root moves that a symmetry of the board maps onto each other are searched once.
+    bool rootSymmetry = true;
+    // Transposition table keys shared by the 8 symmetric images of a position.
+    bool canonicalHash = false;
+};
+
+struct Limits
+{
+    int depth = LIMIT_DEPTH;
+    // Zero time and nodes search to depth at once, otherwise iterative deepening up to depth.
+    std::chrono::milliseconds time{0};
+    unsigned long long nodes = 0;
+    // Called after every completed iteration and at most every 100 ms in between.
+    std::function<void(const SearchStats &)> progress;
+    // Searches from empty tables and without the clock, so that the same position and limits
+    // always visit the same nodes; time is ignored then. Tables joined with shareHash are not
+    // cleared, the search is not reproducible on them.
+    bool deterministic = false;
+};
+
 class Engine
 {
 private:
     Evaluation::Evaluator evaluator;
+    // The network scores the leaves instead of the shape weights when set, the evaluator
+    // still detects fives and orders the moves.
+    std::shared_ptr<const Evaluation::Network> network;
+    Evaluation::Accumulator accumulator;
+    std::shared_ptr<const Evaluation::PolicyNetwork> policy;
+    Evaluation::PolicyCache policyCache;
+    std::shared_ptr<const OpeningBook> book;
+    std::shared_ptr<SolvedStore> solved;
     Game::MovesGenerator generator;
     TranspositionTable pvsTT;
     TranspositionTable vcfTT;
-    QStack<QPoint> moveHistory;
-    QPoint bestPoint;
-    std::array<std::array<Stone, 15>, 15> board;
+    SearchStats stats;
+    Parameters parameters;
+    std::array<size_t, 226> moveCounts;
+    std::vector<Point> moveHistory;
+    Point bestPoint;
+    Board board;
+    // board as of the last move or undo outside a search.
+    PublishedBoard published;
     std::array<std::string, 72> blackShapes;
     std::array<std::string, 72> whiteShapes;
-    unsigned long long cutNodeCount;
-    unsigned long long hitNodeCount;
     unsigned long long nodeCount;
+    unsigned long long nodeLimit;
+    unsigned long long probeBase;
+    unsigned long long hitBase;
+    std::function<void(const SearchStats &)> progress;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point reportTime;
+    std::chrono::steady_clock::time_point deadline;
     int ply;
+    // boardSymmetries of the root board, with Parameters::rootSymmetry.
+    int rootSymmetries;
+    bool timeLimited;
+    bool stopped;
+    bool searching;
 
 public:
     Engine();
-    [[nodiscard]] static bool isLegal(const QPoint &move);
-    void move(const QPoint &point, const Stone &stone);
+    explicit Engine(const size_t &hashSize);
+    Engine(const size_t &hashSize, const unsigned long long &seed);
+    Engine(const size_t &hashSize, const ZobristKeys &keys);
+    [[nodiscard]] static bool isLegal(const Point &move);
+    void move(const Point &point, const Stone &stone);
     void undo(const int &step);
-    [[nodiscard]] Stone checkStone(const QPoint &point) const;
-    [[nodiscard]] Status gameStatus(const QPoint &move, const Stone &stone) const;
-    [[nodiscard]] QPoint bestMove(const Stone &stone);
-    [[nodiscard]] QPoint lastMove() const;
+    [[nodiscard]] Stone checkStone(const Point &point) const;
+    [[nodiscard]] Status gameStatus(const Point &move, const Stone &stone) const;
+    [[nodiscard]] Point bestMove(const Stone &stone);
+    [[nodiscard]] Point bestMove(const Stone &stone, const Limits &limits);
+    [[nodiscard]] SearchStats search(const Stone &stone, const Limits &limits = {});
+    [[nodiscard]] Point lastMove() const;
+    // The game position without the moves tried by a running search, safe to read from any
+    // thread while another one moves or searches.
+    [[nodiscard]] BoardSnapshot publishedBoard() const;
+    [[nodiscard]] const SearchStats &searchStats() const;
+    void setHashSize(const size_t &hashSize);
+    void clearHash();
+    // Moves both tables into the shared memory segments name-pvs and name-vcf, so that engines
+    // in this and other processes read each other's entries. Needs a name of the form /name.
+    bool shareHash(const std::string &name);
+    // The moves played and both transposition tables, to resume an analysis in another process.
+    bool saveSnapshot(const std::string &path) const;
+    bool loadSnapshot(const std::string &path);
+    [[nodiscard]] const Parameters &searchParameters() const;
+    void setParameters(const Parameters &parameters);
+    void setWeights(const Evaluation::Weights &weights);
+    void setNetwork(std::shared_ptr<const Evaluation::Network> network);
+    void setPolicy(std::shared_ptr<const Evaluation::PolicyNetwork> policy);
+    void setBook(std::shared_ptr<const OpeningBook> book);
+    void setSolvedStore(std::shared_ptr<SolvedStore> solved);
+    // For tree searches: the moves of the side to move with their prior probabilities, and the
+    // static evaluation, Max or Min once a five is on the board.
+    [[nodiscard]] std::vector<std::pair<Point, float>> movePriors(const Stone &stone);
+    [[nodiscard]] int evaluate(const Stone &stone) const;
 
 private:
-    static bool inMated(const Stone &stone, QHash<QPoint, QPair<int, int>> &moves);
+    bool timeout();
+    [[nodiscard]] int staticEvaluation(const Stone &stone,
+                                       const int &firstScore,
+                                       const int &secondScore) const;
+    const SearchStats &collectStats();
+    [[nodiscard]] unsigned long long policyKey(const Stone &stone) const;
+    const Evaluation::PolicyLogits &policyLogits(const Stone &stone);
+    void evaluateRootPolicy(const Stone &stone);
+    void applyPolicy(const Stone &stone,
+                     const std::unordered_map<Point, std::pair<int, int>> &moves,
+                     std::vector<std::pair<int, Point>> &candidates);
+    void removeSymmetricMoves(std::vector<std::pair<int, Point>> &candidates);
+    std::vector<Point> principalVariation(const Stone &stone, const Point &firstMove);
+    void proveWin(const Stone &stone);
+    void storeSolutions(const Stone &stone);
+    static bool inMated(const Stone &stone, std::unordered_map<Point, std::pair<int, int>> &moves);
     template<NodeType NT>
     int pvs(const Stone &stone,
             int alpha,
@@ -0,0 +1,486 @@
+#include "mcts.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+using namespace Search;
+
+MctsEngine::MctsEngine(const size_t &threads, const size_t &treeSize)
+    : pool(threads)
+    , capacity(std::max<size_t>(2, std::min<size_t>(treeSize / 2 / sizeof(Node), INT_MAX)))
+    , arena(0)
+    , used(0)
+    , playouts(0)
+    , seldepth(0)
+    , stopped(false)
+    , playoutLimit(0)
+    , timeLimited(false)
+    , cacheSize(0)
+{
+    // The workers only follow the game and evaluate, their tables stay small.
+    for (size_t i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Engine>(1 << 20));
+    }
+
+    for (auto &nodes : arenas) {
+        nodes = std::make_unique<Node[]>(capacity);
+    }
+
+    resetTree();
+}
+
+bool MctsEngine::isLegal(const Point &move)
+{
+    return Engine::isLegal(move);
+}
+
+// Keeps the subtree of the move when it has been searched, starts a new tree otherwise.
+void MctsEngine::move(const Point &point, const Stone &stone)
+{
+    const auto &root = node(0);
+    int child = -1;
+
+    if (root.state.load(std::memory_order_acquire) == Expanded) {
+        for (int i = 0; i < root.childCount; ++i) {
+            if (node(root.firstChild + i).move == point) {
+                child = root.firstChild + i;
+
+                break;
+            }
+        }
+    }
+
+    for (auto &worker : workers) {
+        worker->move(point, stone);
+    }
+
+    moveHistory.push_back(point);
+
+    if (child >= 0 && node(child).visits.load(std::memory_order_relaxed) > 0) {
+        keepSubtree(child);
+    } else {
+        resetTree();
+    }
+}
+
+void MctsEngine::undo(const int &step)
+{
+    for (auto &worker : workers) {
+        worker->undo(step);
+    }
+
+    moveHistory.resize(moveHistory.size() - step);
+    resetTree();
+}
+
+Stone MctsEngine::checkStone(const Point &point) const
+{
+    return workers.front()->checkStone(point);
+}
+
+Status MctsEngine::gameStatus(const Point &move, const Stone &stone) const
+{
+    return workers.front()->gameStatus(move, stone);
+}
+
+Point MctsEngine::bestMove(const Stone &stone)
+{
+    return bestMove(stone, Limits{});
+}
+
+Point MctsEngine::bestMove(const Stone &stone, const Limits &limits)
+{
+    return search(stone, limits).bestMove;
+}
+
+SearchStats MctsEngine::search(const Stone &stone, const Limits &limits)
+{
+    stats = {};
+
+    if (const auto last = lastMove();
+        moveHistory.empty()
+        || (moveHistory.size() == 1 && last != Point{7, 7} && checkStone(last) != stone)) {
+        stats.bestMove = {7, 7};
+        stats.pv = {stats.bestMove};
+
+        return stats;
+    }
+
+    startTime = std::chrono::steady_clock::now();
+    deadline = startTime + limits.time;
+    timeLimited = limits.time.count() > 0;
+    playoutLimit = limits.nodes ? limits.nodes : timeLimited ? ULLONG_MAX : MCTS_PLAYOUTS;
+    playouts = 0;
+    seldepth = 0;
+    stopped = false;
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        pool.submit([this, &stone, &limits](const size_t &worker) {
+            auto reportTime = startTime;
+
+            if (cacheSize) {
+                Evaluation::Evaluator::setCacheSize(cacheSize);
+            }
+
+            while (!stopped.load(std::memory_order_relaxed)) {
+                if (playouts.fetch_add(1, std::memory_order_relaxed) >= playoutLimit) {
+                    stopped = true;
+
+                    break;
+                }
+
+                playout(*workers[worker], stone);
+
+                const auto now = std::chrono::steady_clock::now();
+
+                if (timeLimited && now >= deadline) {
+                    stopped = true;
+                }
+
+                // Only the first worker reports, the others would race on the stats.
+                if (limits.progress && !worker
+                    && now - reportTime >= std::chrono::milliseconds(100)) {
+                    reportTime = now;
+
+                    limits.progress(collectStats());
+                }
+            }
+        });
+    }
+
+    pool.wait();
+
+    const auto &root = node(0);
+
+    if (root.state.load(std::memory_order_acquire) == Expanded) {
+        const auto &best = node(mostVisited(root));
+        const auto visits = best.visits.load(std::memory_order_relaxed);
+        const auto q = visits ? static_cast<double>(best.value.load(std::memory_order_relaxed))
+                                    / VALUE_ONE / visits
+                              : 0.0;
+
+        stats.bestMove = best.move;
+        stats.score = best.state.load(std::memory_order_acquire) == Terminal && best.result > 0
+                          ? Max - 1
+                          : static_cast<int>(std::atanh(std::clamp(q, -0.999, 0.999))
+                                             * parameters.valueScale);
+    } else if (const auto priors = workers.front()->movePriors(stone); !priors.empty()) {
+        stats.bestMove = priors.front().first;
+    }
+
+    stats.pv = principalVariation();
+
+    if (stats.pv.empty() && isLegal(stats.bestMove)) {
+        stats.pv = {stats.bestMove};
+    }
+
+    collectStats();
+
+    return stats;
+}
+
+Point MctsEngine::lastMove() const
+{
+    return moveHistory.empty() ? Point{-1, -1} : moveHistory.back();
+}
+
+const SearchStats &MctsEngine::searchStats() const
+{
+    return stats;
+}
+
+const MctsParameters &MctsEngine::searchParameters() const
+{
+    return parameters;
+}
+
+void MctsEngine::setParameters(const MctsParameters &parameters)
+{
+    this->parameters = parameters;
+    resetTree();
+}
+
+void MctsEngine::setWeights(const Evaluation::Weights &weights)
+{
+    for (auto &worker : workers) {
+        worker->setWeights(weights);
+    }
+
+    resetTree();
+}
+
+void MctsEngine::setCacheSize(const size_t &bytes)
+{
+    cacheSize = bytes;
+}
+
+void MctsEngine::setNetwork(std::shared_ptr<const Evaluation::Network> network)
+{
+    for (auto &worker : workers) {
+        worker->setNetwork(network);
+    }
+
+    resetTree();
+}
+
+void MctsEngine::setPolicy(std::shared_ptr<const Evaluation::PolicyNetwork> policy)
+{
+    for (auto &worker : workers) {
+        worker->setPolicy(policy);
+    }
+
+    resetTree();
+}
+
+void MctsEngine::copyNode(const Node &from, Node &to)
+{
+    to.value.store(from.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    to.state.store(from.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    to.firstChild = from.firstChild;
+    to.childCount = from.childCount;
+    to.prior = from.prior;
+    to.result = from.result;
+    to.move = from.move;
+}
+
+MctsEngine::Node &MctsEngine::node(const int &index) const
+{
+    return arenas[arena][index];
+}
+
+void MctsEngine::resetTree()
+{
+    copyNode(Node{}, node(0));
+    used = 1;
+}
+
+// Copies the subtree of the node to the root of the other arena, breadth first so that the
+// children of every node stay contiguous.
+void MctsEngine::keepSubtree(const int &index)
+{
+    auto &target = arenas[1 - arena];
+    std::deque<std::pair<int, int>> queue{{index, 0}};
+    int next = 1;
+
+    copyNode(node(index), target[0]);
+
+    while (!queue.empty()) {
+        const auto [from, to] = queue.front();
+        const auto &source = node(from);
+
+        queue.pop_front();
+
+        if (source.state.load(std::memory_order_relaxed) != Expanded) {
+            continue;
+        }
+
+        target[to].firstChild = next;
+
+        for (int i = 0; i < source.childCount; ++i) {
+            copyNode(node(source.firstChild + i), target[next + i]);
+            queue.emplace_back(source.firstChild + i, next + i);
+        }
+
+        next += source.childCount;
+    }
+
+    arena = 1 - arena;
+    used = next;
+}
+
+// Descends by PUCT with a virtual loss on every node of the path, expands or scores the leaf
+// and backs its result up, negated at every ply.
+void MctsEngine::playout(Engine &engine, const Stone &stone)
+{
+    thread_local std::vector<int> path;
+    auto side = stone;
+    int index = 0;
+    float value;
+
+    path.clear();
+    node(0).visits.fetch_add(1, std::memory_order_relaxed);
+
+    while (true) {
+        auto &current = node(index);
+        const auto state = current.state.load(std::memory_order_acquire);
+
+        if (state == Terminal) {
+            value = current.result;
+
+            break;
+        }
+
+        if (state != Expanded) {
+            value = expand(engine, current, side);
+
+            break;
+        }
+
+        index = select(current);
+
+        auto &child = node(index);
+
+        child.visits.fetch_add(1, std::memory_order_relaxed);
+        child.value.fetch_sub(VALUE_ONE, std::memory_order_relaxed);
+        engine.move(child.move, side);
+        path.push_back(index);
+        side = static_cast<Stone>(-side);
+    }
+
+    const auto depth = static_cast<int>(path.size());
+
+    for (auto it = path.crbegin(); it != path.crend(); ++it) {
+        node(*it).value.fetch_add(std::llround((value + 1) * VALUE_ONE),
+                                  std::memory_order_relaxed);
+        value = -value;
+    }
+
+    node(0).value.fetch_add(std::llround(value * VALUE_ONE), std::memory_order_relaxed);
+    engine.undo(depth);
+
+    for (auto deepest = seldepth.load(std::memory_order_relaxed);
+         depth > deepest && !seldepth.compare_exchange_weak(deepest, depth);) {}
+}
+
+// Result of the leaf for the side that moved into it. The thread that claims the leaf adds
+// its children, the others only score it.
+float MctsEngine::expand(Engine &engine, Node &leaf, const Stone &stone)
+{
+    const auto evaluation = engine.evaluate(stone);
+    auto expected = static_cast<unsigned char>(Leaf);
+
+    if (evaluation == Min || evaluation == Max) {
+        const auto result = evaluation == Min ? 1.0F : -1.0F;
+
+        if (leaf.state.compare_exchange_strong(expected, Expanding, std::memory_order_acquire)) {
+            leaf.result = result;
+            leaf.state.store(Terminal, std::memory_order_release);
+        }
+
+        return result;
+    }
+
+    const auto value = static_cast<float>(-std::tanh(evaluation / parameters.valueScale));
+
+    if (!leaf.state.compare_exchange_strong(expected, Expanding, std::memory_order_acquire)) {
+        return value;
+    }
+
+    auto priors = engine.movePriors(stone);
+
+    if (priors.empty()) {
+        leaf.result = 0;
+        leaf.state.store(Terminal, std::memory_order_release);
+
+        return 0;
+    }
+
+    const auto count = std::min(priors.size(), static_cast<size_t>(parameters.maxChildren));
+    const auto first = used.fetch_add(count, std::memory_order_relaxed);
+
+    // A full arena leaves the tree as it is until the next move frees it.
+    if (first + count > capacity) {
+        leaf.state.store(Leaf, std::memory_order_release);
+
+        return value;
+    }
+
+    float total = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        total += priors[i].second;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto &child = node(static_cast<int>(first + i));
+
+        copyNode(Node{}, child);
+        child.prior = priors[i].second / total;
+        child.move = priors[i].first;
+    }
+
+    leaf.firstChild = static_cast<int>(first);
+    leaf.childCount = static_cast<int>(count);
+    leaf.state.store(Expanded, std::memory_order_release);
+
+    return value;
+}
+
+// PUCT: mean result plus the prior scaled by the parent visits over the child visits.
+// Unvisited children take the parent's mean result for the side to move.
+int MctsEngine::select(const Node &parent) const
+{
+    const auto parentVisits = parent.visits.load(std::memory_order_relaxed);
+    const auto exploration = parameters.cPuct * std::sqrt(std::max(parentVisits, 1));
+    const auto firstPlay = parentVisits > 0
+                               ? -static_cast<double>(parent.value.load(std::memory_order_relaxed))
+                                     / VALUE_ONE / parentVisits
+                               : 0.0;
+    auto best = parent.firstChild;
+    auto bestScore = -1e30;
+
+    for (int i = parent.firstChild; i < parent.firstChild + parent.childCount; ++i) {
+        const auto &child = node(i);
+        const auto visits = child.visits.load(std::memory_order_relaxed);
+        const auto q = visits ? static_cast<double>(child.value.load(std::memory_order_relaxed))
+                                    / VALUE_ONE / visits
+                              : firstPlay;
+        const auto score = q + exploration * child.prior / (1 + visits);
+
+        if (score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    return best;
+}
+
+int MctsEngine::mostVisited(const Node &parent) const
+{
+    auto best = parent.firstChild;
+
+    for (int i = parent.firstChild + 1; i < parent.firstChild + parent.childCount; ++i) {
+        const auto visits = node(i).visits.load(std::memory_order_relaxed);
+        const auto bestVisits = node(best).visits.load(std::memory_order_relaxed);
+
+        if (visits > bestVisits || (visits == bestVisits && node(i).prior > node(best).prior)) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+std::vector<Point> MctsEngine::principalVariation() const
+{
+    std::vector<Point> pv;
+    int index = 0;
+
+    while (node(index).state.load(std::memory_order_acquire) == Expanded) {
+        index = mostVisited(node(index));
+
+        if (!node(index).visits.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        pv.push_back(node(index).move);
+    }
+
+    return pv;
+}
+
+const SearchStats &MctsEngine::collectStats()
+{
+    stats.nodes = std::min(playouts.load(std::memory_order_relaxed), playoutLimit);
+    stats.depth = seldepth.load(std::memory_order_relaxed);
+    stats.seldepth = stats.depth;
+    stats.time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime);
+
+    return stats;
+}
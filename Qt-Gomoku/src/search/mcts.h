@@ -0,0 +1,110 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "../algorithm/workstealingpool.hpp"
+#include "../core/types.h"
+#include "engine.h"
+#include "searchstats.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Search {
+inline unsigned long long MCTS_PLAYOUTS = 20000;
+
+struct MctsParameters
+{
+    // Exploration weight of the prior in PUCT.
+    double cPuct = 1.5;
+    // A leaf worth e to the side to move scores tanh(e / valueScale).
+    double valueScale = 2000;
+    // Most likely moves kept per expanded node.
+    int maxChildren = 40;
+};
+
+// Monte Carlo tree search with PUCT selection, alongside the alpha-beta Engine and with the
+// same game surface. Leaves are scored by the static evaluation of the Engine, priors come
+// from its policy network when set, from the move pattern scores otherwise. Worker threads
+// descend the shared tree with virtual loss, each on its own Engine following the game.
+// The subtree of the played moves is kept between searches.
+class MctsEngine
+{
+private:
+    enum NodeState : unsigned char { Leaf, Expanding, Expanded, Terminal };
+
+    struct Node
+    {
+        // Sum of the results of the side that moved into the node, in 1 / VALUE_ONE units.
+        std::atomic<long long> value{0};
+        // Completed and in-flight playouts, the latter counted as losses until they finish.
+        std::atomic<int> visits{0};
+        std::atomic<unsigned char> state{Leaf};
+        int firstChild = -1;
+        int childCount = 0;
+        float prior = 0;
+        // Result of the side that moved into a Terminal node.
+        float result = 0;
+        Point move{-1, -1};
+    };
+
+    static constexpr long long VALUE_ONE = 1 << 16;
+
+    MctsParameters parameters;
+    std::vector<std::unique_ptr<Engine>> workers;
+    Algorithm::WorkStealingPool pool;
+    // The tree lives in one arena, the kept subtree is copied to the other on a move.
+    std::array<std::unique_ptr<Node[]>, 2> arenas;
+    size_t capacity;
+    size_t arena;
+    std::atomic<size_t> used;
+    std::vector<Point> moveHistory;
+    SearchStats stats;
+    std::atomic<unsigned long long> playouts;
+    std::atomic<int> seldepth;
+    std::atomic<bool> stopped;
+    unsigned long long playoutLimit;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point deadline;
+    bool timeLimited;
+    // Bytes of shape caches per search thread, 0 leaves them unbounded.
+    size_t cacheSize;
+
+public:
+    // treeSize is the total size in bytes of both arenas.
+    explicit MctsEngine(const size_t &threads = 1, const size_t &treeSize = 1 << 27);
+    [[nodiscard]] static bool isLegal(const Point &move);
+    void move(const Point &point, const Stone &stone);
+    void undo(const int &step);
+    [[nodiscard]] Stone checkStone(const Point &point) const;
+    [[nodiscard]] Status gameStatus(const Point &move, const Stone &stone) const;
+    [[nodiscard]] Point bestMove(const Stone &stone);
+    [[nodiscard]] Point bestMove(const Stone &stone, const Limits &limits);
+    // limits.nodes counts playouts, MCTS_PLAYOUTS without nodes and time; depth is unused.
+    [[nodiscard]] SearchStats search(const Stone &stone, const Limits &limits = {});
+    [[nodiscard]] Point lastMove() const;
+    [[nodiscard]] const SearchStats &searchStats() const;
+    [[nodiscard]] const MctsParameters &searchParameters() const;
+    void setParameters(const MctsParameters &parameters);
+    void setWeights(const Evaluation::Weights &weights);
+    void setNetwork(std::shared_ptr<const Evaluation::Network> network);
+    void setPolicy(std::shared_ptr<const Evaluation::PolicyNetwork> policy);
+    // Bounds the evaluation shape caches of every search thread, see Evaluator::setCacheSize.
+    void setCacheSize(const size_t &bytes);
+
+private:
+    static void copyNode(const Node &from, Node &to);
+    [[nodiscard]] Node &node(const int &index) const;
+    void resetTree();
+    void keepSubtree(const int &index);
+    void playout(Engine &engine, const Stone &stone);
+    [[nodiscard]] float expand(Engine &engine, Node &leaf, const Stone &stone);
+    [[nodiscard]] int select(const Node &parent) const;
+    [[nodiscard]] int mostVisited(const Node &parent) const;
+    [[nodiscard]] std::vector<Point> principalVariation() const;
+    const SearchStats &collectStats();
+};
+} // namespace Search
+#endif
@@ -0,0 +1,155 @@
+#include "openingbook.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace Search;
+
+namespace {
+constexpr char MAGIC[] = "QTGMKBK1";
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t ENTRY_SIZE = 24;
+
+unsigned long long readLittleEndian(const unsigned char *bytes, const size_t &size)
+{
+    unsigned long long value = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        value |= static_cast<unsigned long long>(bytes[i]) << 8 * i;
+    }
+
+    return value;
+}
+
+void writeLittleEndian(std::ostream &stream, const unsigned long long &value, const size_t &size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        stream.put(static_cast<char>(value >> 8 * i & 0xff));
+    }
+}
+} // namespace
+
+double BookMove::score() const
+{
+    return games ? (wins + 0.5 * draws) / games : 0.5;
+}
+
+OpeningBook::OpeningBook()
+    : count(0)
+{}
+
+std::shared_ptr<const OpeningBook> OpeningBook::open(const std::string &path)
+{
+    auto book = std::make_shared<OpeningBook>();
+
+    if (!book->file.open(path) || book->file.size() < HEADER_SIZE
+        || std::memcmp(book->file.data(), MAGIC, sizeof(MAGIC) - 1) != 0) {
+        return nullptr;
+    }
+
+    book->count = static_cast<size_t>(readLittleEndian(book->file.data() + 8, 8));
+
+    if ((book->file.size() - HEADER_SIZE) / ENTRY_SIZE < book->count) {
+        return nullptr;
+    }
+
+    return book;
+}
+
+size_t OpeningBook::size() const
+{
+    return count;
+}
+
+std::vector<BookMove> OpeningBook::probe(const Board &board, const Stone &stone) const
+{
+    const auto [hash, symmetry] = canonicalHash(board, stone);
+    const auto inverse = inverseSymmetry(symmetry);
+    size_t low = 0;
+    size_t high = count;
+    std::vector<BookMove> moves;
+
+    // Lower bound of the hash.
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+
+        if (entry(middle).hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (auto index = low; index < count; ++index) {
+        const auto current = entry(index);
+
+        if (current.hash != hash) {
+            break;
+        }
+
+        if (current.move >= 225) {
+            continue;
+        }
+
+        const auto move = transform({current.move / 15, current.move % 15}, inverse);
+
+        if (board[move.x][move.y] == Empty) {
+            moves.push_back({move, current.games, current.wins, current.draws});
+        }
+    }
+
+    return moves;
+}
+
+BookEntry OpeningBook::entry(const size_t &index) const
+{
+    const auto *bytes = file.data() + HEADER_SIZE + index * ENTRY_SIZE;
+    BookEntry entry;
+
+    entry.hash = readLittleEndian(bytes, 8);
+    entry.games = static_cast<unsigned>(readLittleEndian(bytes + 8, 4));
+    entry.wins = static_cast<unsigned>(readLittleEndian(bytes + 12, 4));
+    entry.draws = static_cast<unsigned>(readLittleEndian(bytes + 16, 4));
+    entry.move = bytes[20];
+
+    return entry;
+}
+
+bool Search::saveBook(const std::string &path, std::vector<BookEntry> entries)
+{
+    const auto less = [](const BookEntry &lhs, const BookEntry &rhs) {
+        return lhs.hash != rhs.hash ? lhs.hash < rhs.hash : lhs.move < rhs.move;
+    };
+
+    std::sort(entries.begin(), entries.end(), less);
+
+    std::vector<BookEntry> merged;
+
+    for (const auto &entry : entries) {
+        if (!merged.empty() && merged.back().hash == entry.hash
+            && merged.back().move == entry.move) {
+            merged.back().games += entry.games;
+            merged.back().wins += entry.wins;
+            merged.back().draws += entry.draws;
+        } else {
+            merged.push_back(entry);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+
+    file.write(MAGIC, sizeof(MAGIC) - 1);
+    writeLittleEndian(file, merged.size(), 8);
+
+    for (const auto &entry : merged) {
+        writeLittleEndian(file, entry.hash, 8);
+        writeLittleEndian(file, entry.games, 4);
+        writeLittleEndian(file, entry.wins, 4);
+        writeLittleEndian(file, entry.draws, 4);
+        writeLittleEndian(file, entry.move, 1);
+        writeLittleEndian(file, 0, 3);
+    }
+
+    return static_cast<bool>(file);
+}
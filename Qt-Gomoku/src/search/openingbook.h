@@ -0,0 +1,61 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include "../core/mappedfile.h"
+#include "../core/types.h"
+#include "zobrist.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Search {
+struct BookMove
+{
+    Point move{-1, -1};
+    unsigned games = 0;
+    // Games won and drawn by the side playing the move.
+    unsigned wins = 0;
+    unsigned draws = 0;
+
+    [[nodiscard]] double score() const;
+};
+
+// One move of one canonical position, as stored in the book.
+struct BookEntry
+{
+    unsigned long long hash = 0;
+    // x * 15 + y of the move on the canonical board.
+    unsigned char move = 0;
+    unsigned games = 0;
+    unsigned wins = 0;
+    unsigned draws = 0;
+};
+
+// A book file mapped into memory and searched in place, so opening it reads nothing.
+// Binary form: "QTGMKBK1", the entry count as a little-endian uint64, then the entries sorted
+// by hash and move, each the hash as a little-endian uint64, games, wins and draws as
+// little-endian uint32, the move byte and 3 reserved bytes. Positions are keyed by
+// canonicalHash, their moves transformed by the same symmetry.
+class OpeningBook
+{
+private:
+    MappedFile file;
+    size_t count;
+
+public:
+    OpeningBook();
+    // nullptr when the file is missing or malformed.
+    [[nodiscard]] static std::shared_ptr<const OpeningBook> open(const std::string &path);
+    [[nodiscard]] size_t size() const;
+    // The book moves of the position on its own board, O(log n) in the book size.
+    [[nodiscard]] std::vector<BookMove> probe(const Board &board, const Stone &stone) const;
+
+private:
+    [[nodiscard]] BookEntry entry(const size_t &index) const;
+};
+
+// Sorts the entries, merging the duplicates, and writes them as a book file.
+bool saveBook(const std::string &path, std::vector<BookEntry> entries);
+} // namespace Search
+#endif
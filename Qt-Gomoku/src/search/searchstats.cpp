@@ -0,0 +1,26 @@
+#include "searchstats.h"
+
+using namespace Search;
+
+double SearchStats::nodesPerSecond() const
+{
+    const auto seconds = std::chrono::duration<double>(time).count();
+
+    return seconds > 0 ? nodes / seconds : 0;
+}
+
+double SearchStats::ttHitRate() const
+{
+    return ttProbes ? static_cast<double>(ttHits) / ttProbes : 0;
+}
+
+std::vector<double> SearchStats::branchingFactors() const
+{
+    std::vector<double> factors;
+
+    for (size_t i = 1; i < iterationNodes.size() && iterationNodes[i - 1]; ++i) {
+        factors.push_back(static_cast<double>(iterationNodes[i]) / iterationNodes[i - 1]);
+    }
+
+    return factors;
+}
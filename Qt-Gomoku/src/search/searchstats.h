@@ -0,0 +1,58 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include "../core/types.h"
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+namespace Search {
+struct SearchStats
+{
+    Point bestMove{-1, -1};
+    // The best move followed by the best replies stored in the transposition table.
+    std::vector<Point> pv;
+    int score = 0;
+    // Last completed iteration and deepest distance from the root, VCF included.
+    int depth = 0;
+    int seldepth = 0;
+    unsigned long long nodes = 0;
+    unsigned long long pvsNodes = 0;
+    unsigned long long vcfNodes = 0;
+    unsigned long long ttProbes = 0;
+    unsigned long long ttHits = 0;
+    unsigned long long ttCutoffs = 0;
+    unsigned long long nullMoveCutoffs = 0;
+    unsigned long long multiCutCutoffs = 0;
+    // Static eval beyond beta by the margin, or below alpha and handed to the VCF search.
+    unsigned long long futilityCutoffs = 0;
+    // Candidates dropped for a low policy prior.
+    unsigned long long policyPrunes = 0;
+    // Root candidates dropped as the mirror image of another on a symmetric board.
+    unsigned long long symmetryPrunes = 0;
+    unsigned long long betaCutoffs = 0;
+    unsigned long long vcfCutoffs = 0;
+    // PVS beta cutoffs by index of the move that caused them, the last bucket counts the rest.
+    std::array<unsigned long long, 8> cutoffIndices{};
+    // PVS nodes by distance from the root, over all iterations.
+    std::vector<unsigned long long> plyNodes;
+    // Nodes of each completed iterative deepening iteration, one entry for a fixed depth search.
+    std::vector<unsigned long long> iterationNodes;
+    std::chrono::microseconds time{0};
+    // The move comes from the opening book, nothing was searched.
+    bool bookMove = false;
+    // The result was proven by an earlier search and read from the solved store.
+    bool solved = false;
+    // The score is a win confirmed by the VCF search, or read from the solved store; a win or
+    // loss of the forward pruned search alone is not proven.
+    bool proven = false;
+
+    [[nodiscard]] double nodesPerSecond() const;
+    [[nodiscard]] double ttHitRate() const;
+    // The nodes of each iteration over those of the previous one.
+    [[nodiscard]] std::vector<double> branchingFactors() const;
+};
+} // namespace Search
+
+#endif
@@ -0,0 +1,156 @@
+#include "solvedstore.h"
+#include "../core/mappedfile.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+using namespace Search;
+
+namespace {
+constexpr char MAGIC[] = "QTGMKSV1";
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t RECORD_SIZE = 24;
+
+unsigned long long readLittleEndian(const unsigned char *bytes, const size_t &size)
+{
+    unsigned long long value = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        value |= static_cast<unsigned long long>(bytes[i]) << 8 * i;
+    }
+
+    return value;
+}
+
+void writeLittleEndian(unsigned char *bytes, const unsigned long long &value, const size_t &size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> 8 * i & 0xff);
+    }
+}
+
+unsigned long long checksum(const unsigned char *bytes)
+{
+    auto state = readLittleEndian(bytes, 8) ^ readLittleEndian(bytes + 8, 8);
+
+    return splitMix64(state);
+}
+} // namespace
+
+std::shared_ptr<SolvedStore> SolvedStore::open(const std::string &path)
+{
+    auto store = std::make_shared<SolvedStore>();
+    size_t length = 0;
+
+    {
+        MappedFile mapped;
+
+        if (mapped.open(path) && mapped.size()) {
+            if (mapped.size() < HEADER_SIZE
+                || std::memcmp(mapped.data(), MAGIC, sizeof(MAGIC) - 1) != 0) {
+                return nullptr;
+            }
+
+            length = HEADER_SIZE;
+
+            // Records are replayed in order, a later one replaces an earlier one.
+            while (length + RECORD_SIZE <= mapped.size()) {
+                const auto *bytes = mapped.data() + length;
+
+                if (checksum(bytes) != readLittleEndian(bytes + 16, 8)) {
+                    break;
+                }
+
+                store->records[readLittleEndian(bytes, 8)]
+                    = {bytes[8],
+                       static_cast<signed char>(bytes[9]),
+                       static_cast<unsigned short>(readLittleEndian(bytes + 10, 2))};
+                length += RECORD_SIZE;
+            }
+
+            // Cuts a torn or corrupt tail, so that new records follow the last valid one.
+            if (length < mapped.size()) {
+                mapped.close();
+
+                std::error_code error;
+
+                std::filesystem::resize_file(path, length, error);
+
+                if (error) {
+                    return nullptr;
+                }
+            }
+        }
+    }
+
+    if (!length) {
+        std::ofstream header(path, std::ios::binary | std::ios::trunc);
+        std::array<char, HEADER_SIZE> bytes{};
+
+        std::memcpy(bytes.data(), MAGIC, sizeof(MAGIC) - 1);
+        header.write(bytes.data(), bytes.size());
+
+        if (!header) {
+            return nullptr;
+        }
+    }
+
+    store->file.open(path, std::ios::binary | std::ios::app);
+
+    return store->file ? store : nullptr;
+}
+
+size_t SolvedStore::size() const
+{
+    std::lock_guard lock(mutex);
+
+    return records.size();
+}
+
+std::optional<Solution> SolvedStore::probe(const Board &board, const Stone &stone) const
+{
+    const auto [hash, symmetry] = canonicalHash(board, stone);
+    std::lock_guard lock(mutex);
+
+    if (const auto it = records.find(hash); it != records.cend() && it->second.move < 225) {
+        const auto &[move, result, distance] = it->second;
+        const auto point = transform({move / 15, move % 15}, inverseSymmetry(symmetry));
+
+        if (board[point.x][point.y] == Empty) {
+            return Solution{result, point, distance};
+        }
+    }
+
+    return std::nullopt;
+}
+
+void SolvedStore::store(const Board &board, const Stone &stone, const Solution &solution)
+{
+    const auto [hash, symmetry] = canonicalHash(board, stone);
+    const auto move = transform(solution.move, symmetry);
+    const Record record{static_cast<unsigned char>(move.x * 15 + move.y),
+                        static_cast<signed char>(solution.result),
+                        static_cast<unsigned short>(solution.distance)};
+    std::array<unsigned char, RECORD_SIZE> bytes{};
+    std::lock_guard lock(mutex);
+
+    if (const auto it = records.find(hash);
+        it != records.cend() && it->second.result == record.result
+        && (record.result > 0 ? it->second.distance <= record.distance
+                              : it->second.distance >= record.distance)) {
+        return;
+    }
+
+    records[hash] = record;
+
+    writeLittleEndian(bytes.data(), hash, 8);
+    bytes[8] = record.move;
+    bytes[9] = static_cast<unsigned char>(record.result);
+    writeLittleEndian(bytes.data() + 10, record.distance, 2);
+    writeLittleEndian(bytes.data() + 16, checksum(bytes.data()), 8);
+
+    // One write per record, flushed at once so that a crash loses at most the record in flight.
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    file.flush();
+}
@@ -0,0 +1,56 @@
+#ifndef SOLVEDSTORE_H
+#define SOLVEDSTORE_H
+
+#include "../core/types.h"
+#include "zobrist.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace Search {
+// A proven result from the side to move's point of view.
+struct Solution
+{
+    // 1 for a win, -1 for a loss.
+    int result = 0;
+    Point move{-1, -1};
+    // Plies to the five, the score is Max or Min minus it.
+    int distance = 0;
+};
+
+// Proven wins and losses kept on disk across games and runs, shared by the engines of a process.
+// The file is "QTGMKSV1", 8 reserved bytes and an append-only log of 24 bytes records: the
+// canonicalHash as a little-endian uint64, the move on the canonical board (x * 15 + y), the
+// result as a signed byte, the distance as a little-endian uint16, 4 reserved bytes and a
+// checksum of the first 16 bytes as a little-endian uint64. The log is mapped and indexed on
+// open. Every record goes out in one write, a record torn by a crash fails its checksum and is
+// cut off with everything after it on the next open.
+class SolvedStore
+{
+private:
+    struct Record
+    {
+        unsigned char move;
+        signed char result;
+        unsigned short distance;
+    };
+
+    mutable std::mutex mutex;
+    std::ofstream file;
+    std::unordered_map<unsigned long long, Record> records;
+
+public:
+    // Creates the file if needed, nullptr when it cannot be read or written.
+    [[nodiscard]] static std::shared_ptr<SolvedStore> open(const std::string &path);
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] std::optional<Solution> probe(const Board &board, const Stone &stone) const;
+    // Appends the solution unless the position is known with the same result and a distance as
+    // good, i.e. as short for a win and as long for a loss.
+    void store(const Board &board, const Stone &stone, const Solution &solution);
+};
+} // namespace Search
+#endif
@@ -1,71 +1,330 @@
 #include "transpositiontable.h"
+#include "../core/profiler.h"
 
-#include <QtGlobal>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
-#include <random>
+#if defined(__unix__) || defined(__APPLE__)
+#define GOMOKU_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace Search;
 
+namespace {
+static_assert(std::atomic<unsigned long long>::is_always_lock_free,
+              "Entries are shared between processes");
+static_assert(sizeof(HashEntry) == 16, "Entries are saved and shared as two words");
+
+constexpr char SEGMENT_MAGIC[] = "QTGMKTT1";
+// The buckets of a shared segment start a cache line after the header.
+constexpr size_t SEGMENT_OFFSET = 64;
+
+struct SegmentHeader
+{
+    char magic[8];
+    unsigned long long entrySize;
+    unsigned long long buckets;
+    unsigned long long fingerprint;
+    // Set by the creator once the fields above are written.
+    std::atomic<unsigned long long> ready;
+};
+
+struct EntryData
+{
+    int score;
+    int depth;
+    // x * 15 + y, -1 for none.
+    int move;
+    HashEntry::Type type;
+    Stone stone;
+    int generation;
+};
+
+// score (26 bits, signed), depth (10 bits, signed), move + 1 (8 bits), type (2 bits), stone
+// (2 bits, 0 empty, 1 black, 2 white) and generation (16 bits), from the low bits up. The
+// all-zero word is an empty entry with no move.
+unsigned long long pack(const EntryData &entry)
+{
+    const auto depth = std::clamp(entry.depth, -512, 511);
+    const unsigned long long stone = entry.stone == Black ? 1 : entry.stone == White ? 2 : 0;
+
+    return (static_cast<unsigned long long>(entry.score) & 0x3ffffff)
+           | (static_cast<unsigned long long>(depth) & 0x3ff) << 26
+           | static_cast<unsigned long long>((entry.move + 1) & 0xff) << 36
+           | static_cast<unsigned long long>(entry.type) << 44 | stone << 46
+           | static_cast<unsigned long long>(entry.generation & 0xffff) << 48;
+}
+
+EntryData unpack(const unsigned long long &data)
+{
+    const auto stone = data >> 46 & 3;
+
+    return {static_cast<int>(static_cast<long long>(data << 38) >> 38),
+            static_cast<int>(static_cast<long long>(data << 28) >> 54),
+            static_cast<int>(data >> 36 & 0xff) - 1,
+            static_cast<HashEntry::Type>(data >> 44 & 3),
+            stone == 1   ? Black
+            : stone == 2 ? White
+                         : Empty,
+            static_cast<int>(data >> 48)};
+}
+
+Point toPoint(const int &move)
+{
+    return move >= 0 ? Point{move / 15, move % 15} : Point{-1, -1};
+}
+
+size_t bucketsFor(const size_t &size, const size_t &bucketSize)
+{
+    size_t buckets = 1;
+
+    while (buckets * 2 * bucketSize <= size) {
+        buckets *= 2;
+    }
+
+    return buckets;
+}
+} // namespace
+
 TranspositionTable::TranspositionTable()
-    : TranspositionTable((1 << 28) / sizeof(std::array<HashEntry, 8>)){};
+    : TranspositionTable(1 << 28){};
 
+// size is the table size in bytes, rounded down to a power of two number of buckets.
+// The hash keys are the compile-time ZOBRIST keys, shared by every table and every run.
 TranspositionTable::TranspositionTable(const size_t &size)
-    : hashTable(QVarLengthArray<std::array<HashEntry, 8>>(size))
-    , mask(size - 1)
+    : TranspositionTable(size, ZOBRIST)
+{}
+
+// Keys drawn from seed instead, tables built with the same seed hash alike.
+TranspositionTable::TranspositionTable(const size_t &size, const unsigned long long &seed)
+    : TranspositionTable(size, makeZobristKeys(seed))
+{}
+
+TranspositionTable::TranspositionTable(const size_t &size, const ZobristKeys &keys)
+    : hashTable(nullptr)
+    , bucketCount(0)
+    , segment(nullptr)
+    , segmentSize(0)
+    , symmetricSums({})
+    , mask(0)
     , checkSum(0)
+    , canonical(false)
+    , symmetry(0)
+    , probeCount(0)
+    , hitCount(0)
     , generation(0)
 {
-    std::random_device device;
-    std::default_random_engine engine(device());
-    std::uniform_int_distribution<unsigned long long> distribution;
+    resize(size);
 
-    for (size_t i = 0; i <= mask; ++i) {
-        hashTable[i].fill(HashEntry{0, HashEntry::Exact, {-1, -1}, 0, 0, MISS, Empty});
-    }
+    for (int s = 0; s < 8; ++s) {
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                const auto [i, j] = transform({x, y}, s);
 
-    for (size_t i = 0; i < 15; ++i) {
-        for (size_t j = 0; j < 15; ++j) {
-            blackRandomTable[i][j] = distribution(engine);
-            whiteRandomTable[i][j] = distribution(engine);
+                for (int colour = 0; colour < 2; ++colour) {
+                    symmetricTables[s][colour][x * 15 + y] = keys.stones[colour][i * 15 + j];
+                }
+            }
         }
     }
 }
 
+TranspositionTable::~TranspositionTable()
+{
+    unshare();
+}
+
 void TranspositionTable::insert(const unsigned long long &hashKey,
                                 const HashEntry::Type &type,
-                                const QPoint &move,
+                                const Point &move,
                                 const int &depth,
                                 const int &score,
                                 const Stone &stone)
 {
+    PROFILE_SCOPE(TTInsert);
+
     const auto index = hashKey & mask;
     auto &entries = hashTable[index];
+    const auto age = [this](const EntryData &entry) {
+        return (generation - entry.generation) & 0xffff;
+    };
     auto *replacement = &entries.front();
+    auto replaced = unpack(replacement->data.load(std::memory_order_relaxed));
 
     for (auto &entry : entries) {
-        if (entry.lock == hashKey && entry.stone == stone) {
+        const auto data = entry.data.load(std::memory_order_relaxed);
+        const auto current = unpack(data);
+
+        if ((entry.key.load(std::memory_order_relaxed) ^ data) == hashKey
+            && current.stone == stone) {
             replacement = &entry;
+            replaced = current;
 
             break;
         }
 
-        if (entry.depth - (generation - entry.generation)
-            < replacement->depth - (generation - replacement->generation)) {
+        if (current.depth - age(current) < replaced.depth - age(replaced)) {
             replacement = &entry;
+            replaced = current;
         }
     }
 
-    if (type != HashEntry::Exact && depth + 2 < replacement->depth) {
+    if (type != HashEntry::Exact && depth + 2 < replaced.depth) {
         return;
     }
 
-    replacement->lock = hashKey;
-    replacement->type = type;
-    replacement->move = move == QPoint{-1, -1} ? replacement->move : move;
-    replacement->generation = generation;
-    replacement->depth = depth;
-    replacement->score = score;
-    replacement->stone = stone;
+    const auto stored = move == Point{-1, -1} ? Point{-1, -1}
+                        : canonical           ? transform(move, symmetry)
+                                              : move;
+    const auto data = pack({score,
+                            depth,
+                            stored == Point{-1, -1} ? replaced.move : stored.x * 15 + stored.y,
+                            type,
+                            stone,
+                            generation});
+
+    replacement->data.store(data, std::memory_order_relaxed);
+    replacement->key.store(hashKey ^ data, std::memory_order_relaxed);
+}
+
+// Leaves a shared segment for a private table.
+void TranspositionTable::resize(const size_t &size)
+{
+    unshare();
+
+    bucketCount = bucketsFor(size, sizeof(Bucket));
+    storage.reset();
+    storage = std::make_unique<Bucket[]>(bucketCount);
+    hashTable = storage.get();
+    mask = bucketCount - 1;
+}
+
+// Maps the table onto the named POSIX shared memory segment, creating it with about size bytes
+// or joining it with its own size, so that processes on one machine share their entries. The
+// segment outlives the processes until it is unlinked (shm_unlink, /dev/shm on Linux). False,
+// with the table unchanged, when shared memory is unavailable or the segment was made for
+// another entry layout or other keys.
+bool TranspositionTable::share(const std::string &name, const size_t &size)
+{
+#ifdef GOMOKU_SHM
+    const auto buckets = bucketsFor(size, sizeof(Bucket));
+    auto fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    const auto created = fd >= 0;
+    struct stat status;
+
+    if (!created) {
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if (created && ftruncate(fd, SEGMENT_OFFSET + buckets * sizeof(Bucket)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+
+        return false;
+    }
+
+    // A segment just created by another process may not be sized yet.
+    for (int i = 0; i < 100 && fstat(fd, &status) == 0 && status.st_size == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < SEGMENT_OFFSET) {
+        ::close(fd);
+
+        return false;
+    }
+
+    auto *mapping = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the segment open.
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    auto *header = static_cast<SegmentHeader *>(mapping);
+
+    if (created) {
+        std::memcpy(header->magic, SEGMENT_MAGIC, sizeof(header->magic));
+        header->entrySize = sizeof(HashEntry);
+        header->buckets = buckets;
+        header->fingerprint = fingerprint();
+        header->ready.store(1, std::memory_order_release);
+    } else {
+        for (int i = 0; i < 100 && !header->ready.load(std::memory_order_acquire); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    if (!header->ready.load(std::memory_order_acquire)
+        || std::memcmp(header->magic, SEGMENT_MAGIC, sizeof(header->magic)) != 0
+        || header->entrySize != sizeof(HashEntry) || header->fingerprint != fingerprint()
+        || !header->buckets || header->buckets & (header->buckets - 1)
+        || (static_cast<size_t>(status.st_size) - SEGMENT_OFFSET) / sizeof(Bucket)
+               < header->buckets) {
+        munmap(mapping, status.st_size);
+
+        return false;
+    }
+
+    unshare();
+    storage.reset();
+    segment = mapping;
+    segmentSize = status.st_size;
+    bucketCount = header->buckets;
+    hashTable = reinterpret_cast<Bucket *>(static_cast<char *>(mapping) + SEGMENT_OFFSET);
+    mask = bucketCount - 1;
+
+    return true;
+#else
+    static_cast<void>(name);
+    static_cast<void>(size);
+
+    return false;
+#endif
+}
+
+bool TranspositionTable::shared() const
+{
+    return segment;
+}
+
+void TranspositionTable::unshare()
+{
+#ifdef GOMOKU_SHM
+    if (segment) {
+        munmap(segment, segmentSize);
+    }
+#endif
+
+    segment = nullptr;
+    segmentSize = 0;
+}
+
+// Empties the table, a shared one for every process, and restarts the generations. The keys
+// and the current hash are kept.
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (auto &entry : hashTable[i]) {
+            entry.key.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    generation = 0;
 }
 
 void TranspositionTable::aging()
@@ -73,64 +332,251 @@ void TranspositionTable::aging()
     ++generation;
 }
 
-void TranspositionTable::transpose(const QPoint &move, const Stone &stone)
+void TranspositionTable::transpose(const Point &move, const Stone &stone)
 {
     const auto &[x, y] = move;
-    const auto &randomTable = stone == Black ? blackRandomTable : whiteRandomTable;
+    const auto colour = stone == Black ? 0 : 1;
+
+    checkSum ^= symmetricTables[0][colour][x * 15 + y];
+
+    if (!canonical) {
+        return;
+    }
+
+    symmetry = 0;
 
-    checkSum ^= randomTable[x][y];
+    for (int s = 0; s < 8; ++s) {
+        symmetricSums[s] ^= symmetricTables[s][colour][x * 15 + y];
+
+        if (symmetricSums[s] < symmetricSums[symmetry]) {
+            symmetry = s;
+        }
+    }
+}
+
+// Streams the generation, the bucket count and a fingerprint of the keys, then the entries as
+// their key and data words, all 8 bytes in native order.
+bool TranspositionTable::save(std::ostream &stream) const
+{
+    const std::array<unsigned long long, 3> header{static_cast<unsigned long long>(generation),
+                                                   bucketCount,
+                                                   fingerprint()};
+    std::vector<unsigned long long> words;
+
+    stream.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+    words.reserve(1 << 16);
+
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (const auto &entry : hashTable[i]) {
+            words.push_back(entry.key.load(std::memory_order_relaxed));
+            words.push_back(entry.data.load(std::memory_order_relaxed));
+        }
+
+        if (words.size() == words.capacity() || i + 1 == bucketCount) {
+            stream.write(reinterpret_cast<const char *>(words.data()),
+                         static_cast<std::streamsize>(words.size() * sizeof(words.front())));
+            words.clear();
+        }
+    }
+
+    return static_cast<bool>(stream);
+}
+
+// Copies the entries of a saved table into a private one of its size. Returns the bytes read,
+// 0 without a change when the data is short or was hashed with other keys.
+size_t TranspositionTable::load(const unsigned char *data, const size_t &size)
+{
+    std::array<unsigned long long, 3> header{};
+
+    if (size < sizeof(header)) {
+        return 0;
+    }
+
+    std::memcpy(header.data(), data, sizeof(header));
+
+    const auto &[savedGeneration, buckets, savedFingerprint] = header;
+
+    if (savedFingerprint != fingerprint() || !buckets || buckets & (buckets - 1)
+        || (size - sizeof(header)) / sizeof(Bucket) < buckets) {
+        return 0;
+    }
+
+    resize(buckets * sizeof(Bucket));
+
+    const auto *words = data + sizeof(header);
+
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (auto &entry : hashTable[i]) {
+            unsigned long long word[2];
+
+            std::memcpy(word, words, sizeof(word));
+            entry.key.store(word[0], std::memory_order_relaxed);
+            entry.data.store(word[1], std::memory_order_relaxed);
+            words += sizeof(word);
+        }
+    }
+
+    generation = static_cast<int>(savedGeneration);
+
+    return sizeof(header) + buckets * sizeof(Bucket);
+}
+
+// With canonical keys, hash() is the smallest of the board's 8 symmetric hashes, so mirrored
+// and rotated positions share their entries, and moves are stored on the board of that
+// symmetry. Keys must then be the current hash(), moves are mapped through its symmetry.
+void TranspositionTable::setCanonical(const bool &canonical, const Board &board)
+{
+    this->canonical = canonical;
+    symmetricSums.fill(0);
+    symmetry = 0;
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (board[x][y] == Empty) {
+                continue;
+            }
+
+            for (int s = 0; s < 8; ++s) {
+                symmetricSums[s] ^= symmetricTables[s][board[x][y] == Black ? 0 : 1][x * 15 + y];
+            }
+        }
+    }
+
+    for (int s = 1; s < 8; ++s) {
+        if (symmetricSums[s] < symmetricSums[symmetry]) {
+            symmetry = s;
+        }
+    }
 }
 
 unsigned long long TranspositionTable::hash() const
+{
+    return canonical ? symmetricSums[symmetry] : checkSum;
+}
+
+// Tells key sets apart, so that entries are only loaded into a table hashing alike.
+unsigned long long TranspositionTable::fingerprint() const
+{
+    unsigned long long state = 0;
+
+    for (const auto &keys : symmetricTables[0]) {
+        for (const auto &key : keys) {
+            state ^= key;
+            state = splitMix64(state);
+        }
+    }
+
+    return state;
+}
+
+// The plain hash of the board, whether the keys are canonical or not.
+unsigned long long TranspositionTable::boardHash() const
 {
     return checkSum;
 }
 
+size_t TranspositionTable::size() const
+{
+    return bucketCount * sizeof(Bucket);
+}
+
+unsigned long long TranspositionTable::probes() const
+{
+    return probeCount;
+}
+
+unsigned long long TranspositionTable::hits() const
+{
+    return hitCount;
+}
+
+// Stored move of the position, {-1, -1} if there is none, without touching the counters.
+Point TranspositionTable::probeMove(const unsigned long long &hashKey, const Stone &stone) const
+{
+    for (const auto &entry : hashTable[hashKey & mask]) {
+        const auto data = entry.data.load(std::memory_order_relaxed);
+
+        if (const auto current = unpack(data);
+            (entry.key.load(std::memory_order_relaxed) ^ data) == hashKey
+            && current.stone == stone) {
+            const auto move = toPoint(current.move);
+
+            return canonical && move != Point{-1, -1} ? transform(move, inverseSymmetry(symmetry))
+                                                      : move;
+        }
+    }
+
+    return {-1, -1};
+}
+
 int TranspositionTable::probe(const unsigned long long &hashKey,
                               const int &alpha,
                               const int &beta,
                               const int &depth,
                               const Stone &stone,
-                              QPoint &move)
+                              Point &move)
 {
+    PROFILE_SCOPE(TTProbe);
+
     const auto index = hashKey & mask;
     auto &entries = hashTable[index];
 
-    for (auto &[entryLock, entryType, entryMove, entryAge, entryDepth, entryScore, entryStone] :
-         entries) {
-        if (entryLock == hashKey && entryStone == stone) {
-            move = entryMove;
+    ++probeCount;
 
-            entryAge = generation;
+    for (auto &entry : entries) {
+        const auto data = entry.data.load(std::memory_order_relaxed);
+        auto current = unpack(data);
 
-            bool mate = false;
-            int compensation = 0;
+        if ((entry.key.load(std::memory_order_relaxed) ^ data) != hashKey
+            || current.stone != stone) {
+            continue;
+        }
 
-            if (entryScore >= Max - 225) {
-                mate = true;
-                compensation = 1;
-            } else if (entryScore <= Min + 225) {
-                mate = true;
-                compensation = -1;
-            }
+        ++hitCount;
+
+        const auto entryMove = toPoint(current.move);
+
+        move = canonical && entryMove != Point{-1, -1}
+                   ? transform(entryMove, inverseSymmetry(symmetry))
+                   : entryMove;
+
+        if (current.generation != (generation & 0xffff)) {
+            current.generation = generation;
 
-            if (entryDepth >= depth || mate) {
-                switch (entryType) {
-                case HashEntry::Exact:
+            const auto aged = pack(current);
+
+            entry.data.store(aged, std::memory_order_relaxed);
+            entry.key.store(hashKey ^ aged, std::memory_order_relaxed);
+        }
+
+        const auto &[entryScore, entryDepth, _, entryType, entryStone, entryAge] = current;
+        bool mate = false;
+        int compensation = 0;
+
+        if (entryScore >= Max - 225) {
+            mate = true;
+            compensation = 1;
+        } else if (entryScore <= Min + 225) {
+            mate = true;
+            compensation = -1;
+        }
+
+        if (entryDepth >= depth || mate) {
+            switch (entryType) {
+            case HashEntry::Exact:
+                return entryScore + compensation;
+            case HashEntry::LowerBound:
+                if (entryScore >= beta) {
                     return entryScore + compensation;
-                case HashEntry::LowerBound:
-                    if (entryScore >= beta) {
-                        return entryScore + compensation;
-                    }
-
-                    break;
-                case HashEntry::UpperBound:
-                    if (entryScore <= alpha) {
-                        return entryScore + compensation;
-                    }
-
-                    break;
                 }
+
+                break;
+            case HashEntry::UpperBound:
+                if (entryScore <= alpha) {
+                    return entryScore + compensation;
+                }
+
+                break;
             }
         }
     }
@@ -2,54 +2,90 @@
 #define TRANSPOSITIONTABLE_H
 
 #include "../core/types.h"
-
-#include <QPoint>
-#include <QVarLengthArray>
+#include "zobrist.h"
 
 #include <array>
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <ostream>
+#include <string>
 
 namespace Search {
 constexpr auto MISS = INT_MAX;
 
+// Two words, so that entries are published without locks, between threads and processes alike:
+// key is the hash XOR data, and an entry torn by concurrent writers fails the check and reads
+// as a miss. data packs the score, depth, move, type, stone and generation.
 struct HashEntry
 {
-    unsigned long long lock{};
-    enum Type { Exact, LowerBound, UpperBound } type{};
-    QPoint move{};
-    int generation{};
-    int depth{};
-    int score{};
-    Stone stone{};
+    enum Type { Exact, LowerBound, UpperBound };
+
+    std::atomic<unsigned long long> key;
+    std::atomic<unsigned long long> data;
 };
 
 class TranspositionTable
 {
 private:
-    QVarLengthArray<std::array<HashEntry, 8>> hashTable;
-    std::array<std::array<unsigned long long, 15>, 15> blackRandomTable;
-    std::array<std::array<unsigned long long, 15>, 15> whiteRandomTable;
+    using Bucket = std::array<HashEntry, 8>;
+
+    std::unique_ptr<Bucket[]> storage;
+    // storage, or the buckets of the shared memory segment.
+    Bucket *hashTable;
+    size_t bucketCount;
+    void *segment;
+    size_t segmentSize;
+    // The stone keys read through each board symmetry, symmetricTables[0] is the plain one.
+    std::array<std::array<std::array<unsigned long long, 225>, 2>, 8> symmetricTables;
+    std::array<unsigned long long, 8> symmetricSums;
     unsigned long long mask;
     unsigned long long checkSum;
+    bool canonical;
+    int symmetry;
+    unsigned long long probeCount;
+    unsigned long long hitCount;
     int generation;
 
 public:
     TranspositionTable();
-    TranspositionTable(const size_t &size);
+    explicit TranspositionTable(const size_t &size);
+    TranspositionTable(const size_t &size, const unsigned long long &seed);
+    TranspositionTable(const size_t &size, const ZobristKeys &keys);
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+    ~TranspositionTable();
+    void resize(const size_t &size);
+    bool share(const std::string &name, const size_t &size);
+    [[nodiscard]] bool shared() const;
+    void clear();
     void insert(const unsigned long long &hashKey,
                 const HashEntry::Type &type,
-                const QPoint &move,
+                const Point &move,
                 const int &depth,
                 const int &score,
                 const Stone &stone);
     void aging();
-    void transpose(const QPoint &move, const Stone &stone);
+    void transpose(const Point &move, const Stone &stone);
+    bool save(std::ostream &stream) const;
+    [[nodiscard]] size_t load(const unsigned char *data, const size_t &size);
+    void setCanonical(const bool &canonical, const Board &board);
     [[nodiscard]] unsigned long long hash() const;
+    [[nodiscard]] unsigned long long boardHash() const;
+    [[nodiscard]] unsigned long long fingerprint() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] unsigned long long probes() const;
+    [[nodiscard]] unsigned long long hits() const;
+    [[nodiscard]] Point probeMove(const unsigned long long &hashKey, const Stone &stone) const;
     int probe(const unsigned long long &hashKey,
               const int &alpha,
               const int &beta,
               const int &depth,
               const Stone &stone,
-              QPoint &move);
+              Point &move);
+
+private:
+    void unshare();
 };
 } // namespace Search
 
@@ -0,0 +1,141 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "../core/types.h"
+
+#include <array>
+
+namespace Search {
+using Board = std::array<std::array<Stone, 15>, 15>;
+
+// The 8 symmetries of the board, bit 2 mirrors, bits 0-1 rotate a quarter turn each.
+constexpr Point transform(Point point, const int &symmetry)
+{
+    if (symmetry & 4) {
+        point.x = 14 - point.x;
+    }
+
+    for (int i = 0; i < (symmetry & 3); ++i) {
+        point = {point.y, 14 - point.x};
+    }
+
+    return point;
+}
+
+// Reflections undo themselves, rotations turn back.
+constexpr int inverseSymmetry(const int &symmetry)
+{
+    return symmetry & 4 ? symmetry : (4 - symmetry) & 3;
+}
+
+// Bit s is set for every symmetry s > 0 mapping the board onto itself.
+constexpr int boardSymmetries(const Board &board)
+{
+    int symmetries = 0;
+
+    for (int symmetry = 1; symmetry < 8; ++symmetry) {
+        bool same = true;
+
+        for (int x = 0; x < 15 && same; ++x) {
+            for (int y = 0; y < 15 && same; ++y) {
+                const auto [i, j] = transform({x, y}, symmetry);
+
+                same = board[i][j] == board[x][y];
+            }
+        }
+
+        symmetries |= same << symmetry;
+    }
+
+    return symmetries;
+}
+
+// Zobrist keys fixed at compile time, so that hashes agree across tables, processes and files.
+struct ZobristKeys
+{
+    std::array<std::array<unsigned long long, 225>, 2> stones{};
+    unsigned long long whiteToMove = 0;
+};
+
+constexpr unsigned long long splitMix64(unsigned long long &state)
+{
+    auto z = state += 0x9e3779b97f4a7c15ULL;
+
+    z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+
+    return z ^ z >> 31;
+}
+
+constexpr ZobristKeys makeZobristKeys(unsigned long long seed)
+{
+    ZobristKeys keys;
+
+    for (auto &table : keys.stones) {
+        for (auto &key : table) {
+            key = splitMix64(seed);
+        }
+    }
+
+    keys.whiteToMove = splitMix64(seed);
+
+    return keys;
+}
+
+inline constexpr auto ZOBRIST = makeZobristKeys(0x5147474d4b5a4f42ULL);
+
+constexpr unsigned long long zobristKey(const Point &point, const Stone &stone)
+{
+    return ZOBRIST.stones[stone == Black ? 0 : 1][point.x * 15 + point.y];
+}
+
+// Hashes of the board and the side to move under every symmetry, each one the plain hash of
+// the transformed board.
+constexpr std::array<unsigned long long, 8> symmetricHashes(const Board &board, const Stone &stone)
+{
+    std::array<unsigned long long, 8> hashes{};
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (board[x][y] == Empty) {
+                continue;
+            }
+
+            for (int symmetry = 0; symmetry < 8; ++symmetry) {
+                hashes[symmetry] ^= zobristKey(transform({x, y}, symmetry), board[x][y]);
+            }
+        }
+    }
+
+    if (stone == White) {
+        for (auto &hash : hashes) {
+            hash ^= ZOBRIST.whiteToMove;
+        }
+    }
+
+    return hashes;
+}
+
+struct CanonicalHash
+{
+    unsigned long long hash;
+    // The first symmetry taking the board to its canonical form.
+    int symmetry;
+};
+
+// The smallest of the symmetric hashes: equal for all 8 images of a position.
+constexpr CanonicalHash canonicalHash(const Board &board, const Stone &stone)
+{
+    const auto hashes = symmetricHashes(board, stone);
+    CanonicalHash canonical{hashes[0], 0};
+
+    for (int symmetry = 1; symmetry < 8; ++symmetry) {
+        if (hashes[symmetry] < canonical.hash) {
+            canonical = {hashes[symmetry], symmetry};
+        }
+    }
+
+    return canonical;
+}
+} // namespace Search
+#endif
@@ -0,0 +1,226 @@
+#include "../game/gamedatabase.h"
+#include "../game/position.h"
+#include "../game/record.h"
+#include "../game/recordfile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Round trips of the binary file formats over the bench corpus, run by ctest:
+//   records   writes every position as a record, appends them again, reads both copies back
+//             and replays each record's move order to the same board
+//   database  imports the positions as games in two batches with runs of 16 index entries,
+//             then finds every position of a few games in all 8 symmetries
+// The files are written to the working directory and removed.
+
+#ifndef GOMOKU_BENCH_CORPUS
+#define GOMOKU_BENCH_CORPUS "positions.txt"
+#endif
+
+namespace {
+constexpr char RECORDS_PATH[] = "format-test-records.bin";
+constexpr char DATABASE_PATH[] = "format-test-games.db";
+
+int failures = 0;
+
+void check(const bool &condition, const std::string &what)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+bool sameBoard(const Game::Record &lhs, const Game::Record &rhs)
+{
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (lhs.stone({x, y}) != rhs.stone({x, y})) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// The moves are the same or images of each other under a symmetry mapping the board onto
+// itself, which find cannot tell apart.
+bool sameMove(const Search::Board &board, const Point &lhs, const Point &rhs)
+{
+    if (lhs == rhs) {
+        return true;
+    }
+
+    const auto symmetries = Search::boardSymmetries(board);
+
+    for (int symmetry = 1; symmetry < 8; ++symmetry) {
+        if ((symmetries >> symmetry & 1) && rhs.x >= 0
+            && Search::transform(rhs, symmetry) == lhs) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A score of each sign and a best move for every position, so all the fields are exercised.
+Game::Record expectedRecord(const Game::Position &position, const size_t &index)
+{
+    auto record = Game::toRecord(position);
+
+    record.setScore(static_cast<int>(index * 613 % 20001) - 10000);
+    record.setBest({static_cast<int>(index % 15), static_cast<int>(index / 15 % 15)});
+    record.result = static_cast<Game::Result>(index % 4);
+
+    return record;
+}
+
+void testRecords(const std::vector<Game::Position> &positions)
+{
+    Game::RecordWriter writer;
+
+    // The second pass appends to the file the first one created.
+    for (const auto &append : {false, true}) {
+        check(writer.open(RECORDS_PATH, append), "records: open the writer");
+
+        for (size_t i = 0; i < positions.size(); ++i) {
+            writer.write(expectedRecord(positions[i], i));
+        }
+
+        check(writer.close(), "records: close the writer");
+    }
+
+    Game::RecordReader reader;
+
+    check(reader.open(RECORDS_PATH), "records: open the reader");
+    check(reader.size() == 2 * positions.size(), "records: count");
+
+    for (size_t i = 0; i < reader.size() && i < 2 * positions.size(); ++i) {
+        const auto &position = positions[i % positions.size()];
+        const auto expected = expectedRecord(position, i % positions.size());
+        const auto &record = reader[i];
+        const auto name = "records: " + position.name + " ";
+
+        check(sameBoard(record, expected), name + "board");
+        check(record.side() == expected.side(), name + "side to move");
+        check(record.last() == expected.last(), name + "last move");
+        check(record.best() == expected.best(), name + "best move");
+        check(record.scoreValue() == expected.scoreValue(), name + "score");
+        check(record.result == expected.result, name + "result");
+        check(record.stoneCount() == static_cast<int>(position.moves.size()), name + "stones");
+
+        const auto moves = Game::toMoves(record);
+
+        check(moves && moves->size() == position.moves.size()
+                  && (moves->empty() || moves->back() == position.moves.back())
+                  && sameBoard(Game::toRecord(Game::Position{"", "", *moves}), expected),
+              name + "move order");
+    }
+
+    reader.close();
+    std::remove(RECORDS_PATH);
+}
+
+void testDatabase(const std::vector<Game::Position> &positions)
+{
+    Game::GameDatabaseWriter writer;
+    const auto half = positions.begin() + static_cast<long>(positions.size() / 2);
+    size_t expectedPositions = 0;
+
+    for (const auto &position : positions) {
+        expectedPositions += position.moves.size() + 1;
+    }
+
+    // Far fewer entries per run than positions, so the index is merged from many runs.
+    check(writer.open(DATABASE_PATH, 16), "database: open the writer");
+    writer.append(Game::indexGames({positions.begin(), half}));
+    writer.append(Game::indexGames({half, positions.end()}));
+    check(writer.close(), "database: close the writer");
+
+    const auto database = Game::GameDatabase::open(DATABASE_PATH);
+
+    check(database != nullptr, "database: open");
+
+    if (!database) {
+        return;
+    }
+
+    check(database->size() == positions.size(), "database: game count");
+    check(database->positions() == expectedPositions, "database: position count");
+
+    for (unsigned game = 0; game < positions.size(); ++game) {
+        const auto &position = positions[game];
+        const auto name = "database: game " + std::to_string(game) + " ";
+
+        check(database->name(game) == position.name, name + "name");
+        check(database->moves(game) == position.moves, name + "moves");
+        check(database->result(game) == Game::gameResult(position.moves), name + "result");
+    }
+
+    check(database->name(static_cast<unsigned>(positions.size())).empty(),
+          "database: name past the last game");
+
+    // The first game and the longest one, every ply, in every symmetry of the board.
+    unsigned longest = 0;
+
+    for (unsigned game = 0; game < positions.size(); ++game) {
+        if (positions[game].moves.size() > positions[longest].moves.size()) {
+            longest = game;
+        }
+    }
+
+    for (const auto &game : {0U, longest}) {
+        const auto &moves = positions[game].moves;
+
+        for (size_t ply = 0; ply <= moves.size(); ++ply) {
+            for (int symmetry = 0; symmetry < 8; ++symmetry) {
+                Search::Board board{};
+
+                for (size_t i = 0; i < ply; ++i) {
+                    const auto [x, y] = Search::transform(moves[i], symmetry);
+
+                    board[x][y] = i % 2 ? White : Black;
+                }
+
+                const auto next = ply < moves.size() ? Search::transform(moves[ply], symmetry)
+                                                     : Point{-1, -1};
+                bool found = false;
+
+                for (const auto &hit : database->find(board)) {
+                    found = found
+                            || (hit.game == game && hit.ply == static_cast<int>(ply)
+                                && sameMove(board, hit.next, next));
+                }
+
+                check(found,
+                      "database: find game " + std::to_string(game) + " ply "
+                          + std::to_string(ply) + " symmetry " + std::to_string(symmetry));
+            }
+        }
+    }
+
+    std::remove(DATABASE_PATH);
+}
+} // namespace
+
+int main()
+{
+    const auto positions = Game::loadPositions(GOMOKU_BENCH_CORPUS);
+
+    if (!positions || positions->empty()) {
+        std::cerr << "Cannot load " << GOMOKU_BENCH_CORPUS << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    testRecords(*positions);
+    testDatabase(*positions);
+
+    std::cout << (failures ? "FAILED " : "OK ") << failures << " failures\n";
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
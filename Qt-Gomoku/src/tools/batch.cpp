@@ -0,0 +1,208 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/evaluator.h"
+#include "../game/position.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams positions ("<name> <category> x,y ...", as in the bench corpus) from a file or stdin,
+// analyzes them on a work-stealing pool with one Engine per worker and writes one JSON object
+// per position to stdout in completion order, with the input index to restore the order.
+// Every position is searched from empty tables, so that its result depends neither on the thread
+// count nor on the positions its worker searched before; with node or depth limits it is the same
+// in every run.
+// With --solved, proven wins and losses are read from and added to a solved store file shared
+// by all workers, so that repeated analysis of the same positions skips the search.
+// With --shared-hash, the workers' transposition tables live in POSIX shared memory segments
+// joined by every batch run given the same name, so that concurrent runs search as one.
+
+namespace {
+struct Options
+{
+    std::string input = "-";
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    Search::Limits limits;
+    size_t hashSize = 64;
+    // MB of evaluation shape caches per worker thread.
+    size_t cacheSize = 64;
+    std::shared_ptr<Search::SolvedStore> solved;
+    std::string sharedHash;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--input <file>|-] [--threads <n>] [--depth <n>] [--time <ms>] [--nodes <n>]"
+                 " [--hash <MB per thread>] [--cache-mb <MB per thread>] [--solved <file>]"
+                 " [--shared-hash </name>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--input") {
+            options.input = value;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--depth") {
+            options.limits.depth = std::atoi(value.c_str());
+        } else if (arg == "--time") {
+            options.limits.time = std::chrono::milliseconds(std::atoll(value.c_str()));
+        } else if (arg == "--nodes") {
+            options.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--hash") {
+            options.hashSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--cache-mb") {
+            options.cacheSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--shared-hash") {
+            options.sharedHash = value;
+        } else if (arg == "--solved") {
+            options.solved = Search::SolvedStore::open(value);
+
+            if (!options.solved) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return options.threads > 0 && options.limits.depth > 0 && options.limits.depth <= 225
+           && options.hashSize > 0 && options.cacheSize > 0;
+}
+
+std::string toJson(const size_t &index,
+                   const Game::Position &position,
+                   const Search::SearchStats &stats)
+{
+    std::ostringstream stream;
+
+    stream << "{\"index\":" << index << ",\"position\":\"" << position.name
+           << "\",\"best_move\":\"" << Game::toString(stats.bestMove)
+           << "\",\"score\":" << stats.score << ",\"depth\":" << stats.depth
+           << ",\"seldepth\":" << stats.seldepth << ",\"pv\":[";
+
+    for (size_t i = 0; i < stats.pv.size(); ++i) {
+        stream << (i ? ",\"" : "\"") << Game::toString(stats.pv[i]) << '"';
+    }
+
+    stream << "],\"nodes\":" << stats.nodes << ",\"time_us\":" << stats.time.count()
+           << ",\"solved\":" << (stats.solved ? "true" : "false") << "}";
+
+    return stream.str();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file;
+
+    if (options.input != "-") {
+        file.open(options.input);
+
+        if (!file) {
+            std::cerr << "Cannot open " << options.input << '\n';
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto &input = options.input == "-" ? std::cin : file;
+    std::vector<std::unique_ptr<Search::Engine>> engines;
+    std::mutex outputMutex;
+    const auto start = std::chrono::steady_clock::now();
+    size_t index = 0;
+    size_t invalid = 0;
+    std::string line;
+
+    for (size_t i = 0; i < options.threads; ++i) {
+        engines.push_back(std::make_unique<Search::Engine>(options.hashSize << 20));
+        engines.back()->setSolvedStore(options.solved);
+
+        if (!options.sharedHash.empty() && !engines.back()->shareHash(options.sharedHash)) {
+            std::cerr << "Cannot share the hash as " << options.sharedHash << '\n';
+
+            return 1;
+        }
+    }
+
+    {
+        Algorithm::WorkStealingPool pool(options.threads);
+
+        while (std::getline(input, line)) {
+            if (const auto first = line.find_first_not_of(" \t\r");
+                first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+
+            auto position = Game::parsePosition(line);
+
+            if (!position) {
+                std::cerr << "Skipping invalid position: " << line << '\n';
+                ++invalid;
+
+                continue;
+            }
+
+            // Keep a few positions per worker queued for stealing, without reading the whole input.
+            pool.wait(4 * options.threads);
+            pool.submit([&, index, position = std::move(*position)](const size_t &worker) {
+                auto &engine = *engines[worker];
+
+                Evaluation::Evaluator::setCacheSize(options.cacheSize << 20);
+
+                // Shared tables are kept on purpose, clearing them would wipe every other run's.
+                if (options.sharedHash.empty()) {
+                    engine.clearHash();
+                }
+
+                Game::setup(engine, position);
+
+                const auto stats = engine.search(Game::sideToMove(position), options.limits);
+
+                engine.undo(static_cast<int>(position.moves.size()));
+
+                const auto json = toJson(index, position, stats);
+                std::lock_guard lock(outputMutex);
+
+                std::cout << json << std::endl;
+            });
+
+            ++index;
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    std::cerr << index << " positions analyzed on " << options.threads << " threads in "
+              << elapsed.count() << "s (" << (elapsed.count() > 0 ? index / elapsed.count() : 0)
+              << " positions/s), " << invalid << " skipped\n";
+
+    return invalid ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,458 @@
+#include "../evaluation/nnue.h"
+#include "../evaluation/policy.h"
+#include "../evaluation/weights.h"
+#include "../game/position.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Searches every corpus position to a fixed depth and to a fixed node count and writes
+// one JSON object per search to stdout, followed by a summary object.
+// With --perf, Linux hardware counters of the search thread are added per node.
+
+#ifndef GOMOKU_BENCH_CORPUS
+#define GOMOKU_BENCH_CORPUS "positions.txt"
+#endif
+
+namespace {
+struct Options
+{
+    std::string corpus = GOMOKU_BENCH_CORPUS;
+    int depth = 8;
+    unsigned long long nodes = 200000;
+    size_t hashSize = 64;
+    Evaluation::Weights weights = Evaluation::defaultWeights();
+    std::shared_ptr<const Evaluation::Network> network;
+    std::shared_ptr<const Evaluation::PolicyNetwork> policy;
+    Search::Parameters parameters;
+    bool depthMode = true;
+    bool nodesMode = true;
+    bool perf = false;
+    bool verifyDeterminism = false;
+    // The total node count the run must reproduce, as a regression test.
+    std::optional<unsigned long long> expectedNodes;
+};
+
+enum Counter { Cycles, Instructions, L1DMisses, LLCMisses, BranchMisses, CounterCount };
+
+constexpr std::array<const char *, CounterCount> counterNames
+    = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+using CounterValues = std::array<std::optional<unsigned long long>, CounterCount>;
+
+// Each counter is opened on its own so that a missing one (e.g. in a VM) doesn't disable
+// the others, and is scaled when the kernel had to multiplex it.
+class PerfCounters
+{
+private:
+    std::array<int, CounterCount> fds;
+
+public:
+    PerfCounters()
+    {
+        fds.fill(-1);
+
+#ifdef __linux__
+        constexpr std::array<std::pair<unsigned int, unsigned long long>, CounterCount> events
+            = {{{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HW_CACHE,
+                 PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8
+                     | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}}};
+
+        for (int i = 0; i < CounterCount; ++i) {
+            perf_event_attr attr;
+
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (const auto &fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] bool available() const
+    {
+        return std::any_of(fds.cbegin(), fds.cend(), [](const auto &fd) { return fd >= 0; });
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (const auto &fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    CounterValues stop()
+    {
+        CounterValues values;
+
+#ifdef __linux__
+        for (int i = 0; i < CounterCount; ++i) {
+            // value, time enabled, time running
+            std::array<unsigned long long, 3> data{};
+
+            if (fds[i] < 0) {
+                continue;
+            }
+
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            if (read(fds[i], data.data(), sizeof(data)) == sizeof(data) && data[2]) {
+                values[i] = static_cast<unsigned long long>(
+                    static_cast<double>(data[0]) * data[1] / data[2]);
+            }
+        }
+#endif
+
+        return values;
+    }
+};
+
+struct Totals
+{
+    CounterValues counters;
+    unsigned long long nodes = 0;
+    unsigned long long ttProbes = 0;
+    unsigned long long ttHits = 0;
+    std::chrono::microseconds time{0};
+    int searches = 0;
+    int mismatches = 0;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--corpus <file>] [--depth <n>] [--nodes <n>] [--hash <MB>]"
+                 " [--mode depth|nodes|both] [--weights <file>] [--nnue <file>]"
+                 " [--policy <file>] [--no-symmetry] [--canonical-hash] [--perf]"
+                 " [--verify-determinism] [--expect-nodes <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (arg == "--perf") {
+            options.perf = true;
+
+            continue;
+        }
+
+        if (arg == "--verify-determinism") {
+            options.verifyDeterminism = true;
+
+            continue;
+        }
+
+        if (arg == "--no-symmetry") {
+            options.parameters.rootSymmetry = false;
+
+            continue;
+        }
+
+        if (arg == "--canonical-hash") {
+            options.parameters.canonicalHash = true;
+
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--corpus") {
+            options.corpus = value;
+        } else if (arg == "--depth") {
+            options.depth = std::atoi(value.c_str());
+        } else if (arg == "--nodes") {
+            options.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--expect-nodes") {
+            options.expectedNodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--hash") {
+            options.hashSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--mode" && (value == "depth" || value == "nodes" || value == "both")) {
+            options.depthMode = value != "nodes";
+            options.nodesMode = value != "depth";
+        } else if (arg == "--weights") {
+            const auto weights = Evaluation::loadWeights(value);
+
+            if (!weights) {
+                return false;
+            }
+
+            options.weights = *weights;
+        } else if (arg == "--nnue") {
+            options.network = Evaluation::loadNetwork(value);
+
+            if (!options.network) {
+                return false;
+            }
+        } else if (arg == "--policy") {
+            options.policy = Evaluation::loadPolicy(value);
+
+            if (!options.policy) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return options.depth > 0 && options.nodes > 0 && options.hashSize > 0;
+}
+
+void printCounters(const CounterValues &counters, const unsigned long long &nodes)
+{
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (int i = 0; i < CounterCount; ++i) {
+        std::cout << ",\"" << counterNames[i] << "_per_node\":";
+
+        if (counters[i] && nodes) {
+            std::cout << static_cast<double>(*counters[i]) / nodes;
+        } else {
+            std::cout << "null";
+        }
+    }
+
+    std::cout << ",\"ipc\":";
+
+    if (counters[Cycles] && counters[Instructions] && *counters[Cycles]) {
+        std::cout << static_cast<double>(*counters[Instructions]) / *counters[Cycles];
+    } else {
+        std::cout << "null";
+    }
+
+    std::cout << std::defaultfloat;
+}
+
+void setup(Search::Engine &engine, const Game::Position &position, const Options &options)
+{
+    engine.setParameters(options.parameters);
+    engine.setWeights(options.weights);
+    engine.setNetwork(options.network);
+    engine.setPolicy(options.policy);
+    Game::setup(engine, position);
+}
+
+// Searches again on the same engine, its tables now filled, and on a new engine: a
+// deterministic search must visit the same nodes and return the same result all three times.
+bool reproduces(const Game::Position &position,
+                const Options &options,
+                const Search::Limits &limits,
+                Search::Engine &engine,
+                const Search::SearchStats &stats)
+{
+    Search::Engine fresh(options.hashSize << 20);
+
+    setup(fresh, position, options);
+
+    for (auto *replay : {&engine, &fresh}) {
+        const auto other = replay->search(Game::sideToMove(position), limits);
+
+        if (other.nodes != stats.nodes || other.score != stats.score
+            || other.bestMove != stats.bestMove || other.pv != stats.pv) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void search(const Game::Position &position,
+            const Options &options,
+            const bool &nodesMode,
+            PerfCounters *counters,
+            Totals &totals)
+{
+    Search::Engine engine(options.hashSize << 20);
+    Search::Limits limits;
+
+    setup(engine, position, options);
+
+    if (nodesMode) {
+        limits.depth = 225;
+        limits.nodes = options.nodes;
+    } else {
+        limits.depth = options.depth;
+    }
+
+    limits.deterministic = options.verifyDeterminism;
+
+    if (counters) {
+        counters->start();
+    }
+
+    const auto stats = engine.search(Game::sideToMove(position), limits);
+    const auto values = counters ? counters->stop() : CounterValues{};
+
+    for (int i = 0; i < CounterCount; ++i) {
+        if (values[i]) {
+            totals.counters[i] = totals.counters[i].value_or(0) + *values[i];
+        }
+    }
+
+    const auto deterministic = !options.verifyDeterminism
+                               || reproduces(position, options, limits, engine, stats);
+
+    totals.nodes += stats.nodes;
+    totals.ttProbes += stats.ttProbes;
+    totals.ttHits += stats.ttHits;
+    totals.time += stats.time;
+    ++totals.searches;
+    totals.mismatches += !deterministic;
+
+    std::cout << "{\"position\":\"" << position.name << "\",\"category\":\"" << position.category
+              << "\",\"mode\":\"" << (nodesMode ? "nodes" : "depth")
+              << "\",\"limit\":" << (nodesMode ? options.nodes : options.depth)
+              << ",\"depth\":" << stats.depth << ",\"seldepth\":" << stats.seldepth
+              << ",\"nodes\":" << stats.nodes << ",\"pvs_nodes\":" << stats.pvsNodes
+              << ",\"vcf_nodes\":" << stats.vcfNodes << ",\"time_us\":" << stats.time.count()
+              << ",\"nps\":" << static_cast<unsigned long long>(stats.nodesPerSecond())
+              << ",\"tt_probes\":" << stats.ttProbes << ",\"tt_hits\":" << stats.ttHits
+              << ",\"tt_hit_rate\":" << std::fixed << std::setprecision(4) << stats.ttHitRate()
+              << std::defaultfloat << ",\"tt_cutoffs\":" << stats.ttCutoffs
+              << ",\"null_move_cutoffs\":" << stats.nullMoveCutoffs
+              << ",\"multi_cut_cutoffs\":" << stats.multiCutCutoffs
+              << ",\"futility_cutoffs\":" << stats.futilityCutoffs
+              << ",\"policy_prunes\":" << stats.policyPrunes
+              << ",\"symmetry_prunes\":" << stats.symmetryPrunes
+              << ",\"beta_cutoffs\":" << stats.betaCutoffs
+              << ",\"first_move_cutoff_rate\":" << std::fixed << std::setprecision(4)
+              << (stats.betaCutoffs
+                      ? static_cast<double>(stats.cutoffIndices[0]) / stats.betaCutoffs
+                      : 0.0)
+              << std::defaultfloat << ",\"best_move\":\"" << Game::toString(stats.bestMove)
+              << "\",\"score\":" << stats.score;
+
+    if (options.verifyDeterminism) {
+        std::cout << ",\"deterministic\":" << (deterministic ? "true" : "false");
+    }
+
+    if (counters) {
+        printCounters(values, stats.nodes);
+    }
+
+    std::cout << "}" << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const auto positions = Game::loadPositions(options.corpus);
+
+    if (!positions || positions->empty()) {
+        std::cerr << "Cannot load the corpus " << options.corpus << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    Totals totals;
+    std::optional<PerfCounters> counters;
+
+    if (options.perf) {
+        counters.emplace();
+
+        if (!counters->available()) {
+            std::cerr << "Hardware counters are unavailable (perf_event_open failed or not Linux), "
+                         "reporting null counters\n";
+        }
+    }
+
+    PerfCounters *perf = counters ? &*counters : nullptr;
+
+    for (const auto &position : *positions) {
+        if (options.depthMode) {
+            search(position, options, false, perf, totals);
+        }
+
+        if (options.nodesMode) {
+            search(position, options, true, perf, totals);
+        }
+    }
+
+    const auto seconds = std::chrono::duration<double>(totals.time).count();
+
+    std::cout << "{\"summary\":true,\"searches\":" << totals.searches
+              << ",\"nodes\":" << totals.nodes << ",\"time_us\":" << totals.time.count()
+              << ",\"nps\":"
+              << (seconds > 0 ? static_cast<unsigned long long>(totals.nodes / seconds) : 0)
+              << ",\"tt_probes\":" << totals.ttProbes << ",\"tt_hits\":" << totals.ttHits
+              << ",\"tt_hit_rate\":" << std::fixed << std::setprecision(4)
+              << (totals.ttProbes ? static_cast<double>(totals.ttHits) / totals.ttProbes : 0.0)
+              << std::defaultfloat;
+
+    if (options.verifyDeterminism) {
+        std::cout << ",\"mismatches\":" << totals.mismatches;
+    }
+
+    if (options.perf) {
+        printCounters(totals.counters, totals.nodes);
+    }
+
+    std::cout << "}" << std::endl;
+
+    if (options.expectedNodes && totals.nodes != *options.expectedNodes) {
+        std::cerr << "Searched " << totals.nodes << " nodes instead of " << *options.expectedNodes
+                  << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    return totals.mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
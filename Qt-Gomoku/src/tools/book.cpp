@@ -0,0 +1,155 @@
+#include "../game/recordfile.h"
+#include "../search/openingbook.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Builds an opening book from record files with results, e.g. from gomoku-datagen or
+// gomoku-match --records. Every record with a known last move counts as one game of that move
+// from the position before it, scored for the side that played it. Positions are merged over
+// the 8 board symmetries.
+
+namespace {
+struct Options
+{
+    std::vector<std::string> records;
+    std::string output = "book.bin";
+    int plies = 12;
+    unsigned minGames = 2;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " --records <records.bin> [--records <records.bin> ...] [--output <book.bin>]"
+                 " [--plies <stones before the move>] [--min-games <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--records") {
+            options.records.push_back(value);
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--plies") {
+            options.plies = std::atoi(value.c_str());
+        } else if (arg == "--min-games") {
+            options.minGames = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+
+    return !options.records.empty() && options.plies >= 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    // Keyed by canonical hash and canonical move, so the output is sorted already.
+    std::map<std::pair<unsigned long long, unsigned char>, Search::BookEntry> entries;
+    unsigned long long games = 0;
+
+    for (const auto &path : options.records) {
+        Game::RecordReader reader;
+
+        if (!reader.open(path)) {
+            std::cerr << "Cannot open " << path << '\n';
+
+            return EXIT_FAILURE;
+        }
+
+        for (const auto &record : reader) {
+            const auto last = record.last();
+
+            if (record.result == Game::Result::Unknown || last.x < 0
+                || record.stoneCount() - 1 > options.plies) {
+                continue;
+            }
+
+            const auto stone = record.stone(last);
+            Search::Board board;
+
+            for (int x = 0; x < 15; ++x) {
+                for (int y = 0; y < 15; ++y) {
+                    board[x][y] = record.stone({x, y});
+                }
+            }
+
+            board[last.x][last.y] = Empty;
+
+            const auto hashes = Search::symmetricHashes(board, stone);
+            const auto canonical = Search::canonicalHash(board, stone).hash;
+            auto move = 225;
+
+            // Symmetric positions reach the canonical board in several ways, the smallest
+            // image of the move stands for all of them.
+            for (int symmetry = 0; symmetry < 8; ++symmetry) {
+                if (hashes[symmetry] == canonical) {
+                    const auto image = Search::transform(last, symmetry);
+
+                    move = std::min(move, image.x * 15 + image.y);
+                }
+            }
+
+            auto &entry = entries[{canonical, static_cast<unsigned char>(move)}];
+            const auto winner = record.result == Game::Result::BlackWin   ? Black
+                                : record.result == Game::Result::WhiteWin ? White
+                                                                          : Empty;
+
+            entry.hash = canonical;
+            entry.move = static_cast<unsigned char>(move);
+            ++entry.games;
+            entry.wins += winner == stone;
+            entry.draws += winner == Empty;
+            ++games;
+        }
+    }
+
+    std::vector<Search::BookEntry> book;
+    unsigned long long positions = 0;
+    unsigned long long previous = 0;
+
+    for (const auto &[key, entry] : entries) {
+        if (entry.games < options.minGames) {
+            continue;
+        }
+
+        positions += book.empty() || entry.hash != previous;
+        previous = entry.hash;
+        book.push_back(entry);
+    }
+
+    if (!Search::saveBook(options.output, book)) {
+        std::cerr << "Cannot write " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "{\"games\":" << games << ",\"positions\":" << positions
+              << ",\"entries\":" << book.size() << "}\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+#include "../evaluation/weights.h"
+#include "../search/engine.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+void printBoard(const Search::Engine &engine)
+{
+    std::cout << "   ";
+
+    for (int y = 0; y < 15; ++y) {
+        std::cout << (y < 10 ? " " : "") << y << ' ';
+    }
+
+    std::cout << '\n';
+
+    for (int x = 0; x < 15; ++x) {
+        std::cout << (x < 10 ? " " : "") << x << ' ';
+
+        for (int y = 0; y < 15; ++y) {
+            const auto stone = engine.checkStone({x, y});
+
+            std::cout << ' ' << (stone == Black ? 'X' : stone == White ? 'O' : '.') << ' ';
+        }
+
+        std::cout << '\n';
+    }
+}
+
+void printStats(const Search::SearchStats &stats)
+{
+    std::cerr << "depth " << stats.depth << " seldepth " << stats.seldepth << " score "
+              << stats.score << " nodes " << stats.nodes << " (pvs " << stats.pvsNodes << ", vcf "
+              << stats.vcfNodes << ") nps " << static_cast<unsigned long long>(stats.nodesPerSecond())
+              << " tt " << stats.ttHits << '/' << stats.ttProbes << " time "
+              << stats.time.count() / 1000 << "ms\n";
+}
+
+void printUsage()
+{
+    std::cout << "Commands:\n"
+                 "  move <x> <y>  Place a stone for the side to move.\n"
+                 "  go            Search and play the best move for the side to move.\n"
+                 "  undo [n]      Take back n moves (default 1).\n"
+                 "  board         Print the board.\n"
+                 "  depth <n>     Set the search depth.\n"
+                 "  save <file>   Save the game and the transposition tables.\n"
+                 "  load <file>   Resume from a saved file.\n"
+                 "  quit          Exit.\n";
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    auto weights = Evaluation::defaultWeights();
+
+    for (int i = 1; i < argc; ++i) {
+        if (const std::string arg = argv[i]; arg == "--depth" && i + 1 < argc) {
+            Search::LIMIT_DEPTH = std::atoi(argv[++i]);
+        } else if (arg == "--weights" && i + 1 < argc) {
+            const auto loaded = Evaluation::loadWeights(argv[++i]);
+
+            if (!loaded) {
+                std::cerr << "Cannot load weights from " << argv[i] << '\n';
+
+                return EXIT_FAILURE;
+            }
+
+            weights = *loaded;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--depth <n>] [--weights <file>]\n";
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    Search::Engine engine;
+
+    engine.setWeights(weights);
+    Stone stone = Black;
+    int step = 0;
+    bool gameOver = false;
+    std::string line;
+
+    while (std::getline(std::cin, line)) {
+        std::istringstream stream(line);
+        std::string command;
+
+        if (!(stream >> command)) {
+            continue;
+        }
+
+        if (command == "quit") {
+            break;
+        }
+
+        if (command == "board") {
+            printBoard(engine);
+        } else if (command == "depth") {
+            if (int depth; stream >> depth && depth > 0) {
+                Search::LIMIT_DEPTH = depth;
+            } else {
+                std::cout << "error: invalid depth\n";
+            }
+        } else if (command == "save") {
+            if (std::string path; !(stream >> path) || !engine.saveSnapshot(path)) {
+                std::cout << "error: cannot save\n";
+            }
+        } else if (command == "load") {
+            if (std::string path; !(stream >> path) || !engine.loadSnapshot(path)) {
+                std::cout << "error: cannot load\n";
+
+                continue;
+            }
+
+            const auto last = engine.lastMove();
+
+            step = 0;
+
+            for (int x = 0; x < 15; ++x) {
+                for (int y = 0; y < 15; ++y) {
+                    step += engine.checkStone({x, y}) != Empty;
+                }
+            }
+
+            stone = step ? static_cast<Stone>(-engine.checkStone(last)) : Black;
+            gameOver = step && engine.gameStatus(last, engine.checkStone(last)) != Undecided;
+        } else if (command == "undo") {
+            int count = 1;
+
+            stream >> count;
+
+            if (count <= 0 || count > step) {
+                std::cout << "error: nothing to undo\n";
+
+                continue;
+            }
+
+            engine.undo(count);
+            step -= count;
+            stone = count % 2 ? static_cast<Stone>(-stone) : stone;
+            gameOver = false;
+        } else if (command == "move" || command == "go") {
+            if (gameOver) {
+                std::cout << "error: game over\n";
+
+                continue;
+            }
+
+            Point point{-1, -1};
+
+            if (command == "move") {
+                stream >> point.x >> point.y;
+
+                if (!Search::Engine::isLegal(point) || engine.checkStone(point) != Empty) {
+                    std::cout << "error: illegal move\n";
+
+                    continue;
+                }
+            } else {
+                const auto stats = engine.search(stone);
+
+                point = stats.bestMove;
+
+                printStats(stats);
+
+                std::cout << point.x << ' ' << point.y << '\n';
+            }
+
+            engine.move(point, stone);
+            ++step;
+
+            if (const auto status = engine.gameStatus(point, stone); status == Win) {
+                gameOver = true;
+
+                std::cout << (stone == Black ? "Black" : "White") << " win!\n";
+            } else if (status == Draw) {
+                gameOver = true;
+
+                std::cout << "Draw!\n";
+            }
+
+            stone = static_cast<Stone>(-stone);
+        } else {
+            printUsage();
+        }
+
+        std::cout.flush();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,276 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/evaluator.h"
+#include "../game/record.h"
+#include "../game/recordfile.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Generates training data by self-play: every game starts with random moves around the centre,
+// then the engine plays both sides with a node limit. Every searched position is written as a
+// record with the search score, best move and final result. Games are written whole and in
+// game order, each one depending only on the seed and its index, so the output is identical
+// for any thread count. At most a few games per thread are held in memory.
+
+namespace {
+struct Options
+{
+    std::string output;
+    unsigned long long games = 1000;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    unsigned long long seed = 1;
+    unsigned long long nodes = 5000;
+    int depth = 225;
+    int randomPlies = 6;
+    size_t hashSize = 16;
+    // MB of evaluation shape caches per worker thread.
+    size_t cacheSize = 64;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " --output <records.bin> [--games <n>] [--threads <n>] [--seed <n>]"
+                 " [--nodes <n>] [--depth <n>] [--random-plies <n>] [--hash <MB per thread>]"
+                 " [--cache-mb <MB per thread>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--games") {
+            options.games = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--nodes") {
+            options.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--depth") {
+            options.depth = std::atoi(value.c_str());
+        } else if (arg == "--random-plies") {
+            options.randomPlies = std::atoi(value.c_str());
+        } else if (arg == "--hash") {
+            options.hashSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--cache-mb") {
+            options.cacheSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return !options.output.empty() && options.threads > 0 && options.depth > 0
+           && options.depth <= 225 && options.randomPlies >= 0 && options.randomPlies < 225
+           && options.hashSize > 0 && options.cacheSize > 0;
+}
+
+// SplitMix64, decorrelates the per game seeds.
+unsigned long long mix(unsigned long long value)
+{
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ value >> 30) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ value >> 27) * 0x94d049bb133111ebULL;
+
+    return value ^ value >> 31;
+}
+
+// An empty cell near the stones, or near the centre on an empty board.
+Point randomMove(const Search::Engine &engine, std::mt19937_64 &random)
+{
+    std::vector<Point> candidates;
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (engine.checkStone({x, y}) != Empty) {
+                continue;
+            }
+
+            bool near = !Search::Engine::isLegal(engine.lastMove()) && std::abs(x - 7) <= 2
+                        && std::abs(y - 7) <= 2;
+
+            for (int dx = -2; dx <= 2 && !near; ++dx) {
+                for (int dy = -2; dy <= 2 && !near; ++dy) {
+                    near = Search::Engine::isLegal({x + dx, y + dy})
+                           && engine.checkStone({x + dx, y + dy}) != Empty;
+                }
+            }
+
+            if (near) {
+                candidates.push_back({x, y});
+            }
+        }
+    }
+
+    return candidates.empty() ? Point{-1, -1} : candidates[random() % candidates.size()];
+}
+
+std::vector<Game::Record> playGame(Search::Engine &engine,
+                                   const Options &options,
+                                   const unsigned long long &game)
+{
+    std::mt19937_64 random(mix(options.seed ^ mix(game)));
+    std::vector<Game::Record> records;
+    auto result = Game::Result::Unknown;
+    auto stone = Black;
+    int step = 0;
+
+    Search::Limits limits;
+
+    limits.depth = options.depth;
+    limits.nodes = options.nodes;
+
+    // A game must not depend on what the worker searched before.
+    engine.clearHash();
+
+    while (result == Game::Result::Unknown) {
+        Point move;
+
+        if (step < options.randomPlies) {
+            move = randomMove(engine, random);
+        } else {
+            const auto stats = engine.search(stone, limits);
+            auto record = Game::toRecord(engine, stone);
+
+            move = stats.bestMove;
+            record.setScore(stats.score);
+            record.setBest(move);
+            records.push_back(record);
+        }
+
+        if (!Search::Engine::isLegal(move) || engine.checkStone(move) != Empty) {
+            result = Game::Result::Draw;
+
+            break;
+        }
+
+        engine.move(move, stone);
+        ++step;
+
+        if (const auto status = engine.gameStatus(move, stone); status == Win) {
+            result = stone == Black ? Game::Result::BlackWin : Game::Result::WhiteWin;
+        } else if (status == Draw) {
+            result = Game::Result::Draw;
+        }
+
+        stone = static_cast<Stone>(-stone);
+    }
+
+    engine.undo(step);
+
+    for (auto &record : records) {
+        record.result = result;
+    }
+
+    return records;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Game::RecordWriter writer;
+
+    if (!writer.open(options.output, false)) {
+        std::cerr << "Cannot open " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<Search::Engine>> engines;
+
+    // The same hash keys in every engine, the searches don't depend on the worker.
+    for (size_t i = 0; i < options.threads; ++i) {
+        engines.push_back(std::make_unique<Search::Engine>(options.hashSize << 20, options.seed));
+    }
+
+    // Finished games wait here until all earlier ones are written.
+    std::map<unsigned long long, std::vector<Game::Record>> finished;
+    std::array<unsigned long long, 4> results{};
+    std::mutex mutex;
+    std::condition_variable written;
+    unsigned long long next = 0;
+    unsigned long long positions = 0;
+    const auto window = 4 * options.threads;
+    const auto start = std::chrono::steady_clock::now();
+
+    {
+        Algorithm::WorkStealingPool pool(options.threads);
+
+        for (unsigned long long game = 0; game < options.games; ++game) {
+            {
+                std::unique_lock lock(mutex);
+
+                written.wait(lock, [&] { return game - next < window; });
+            }
+
+            pool.submit([&, game](const size_t &worker) {
+                Evaluation::Evaluator::setCacheSize(options.cacheSize << 20);
+
+                auto records = playGame(*engines[worker], options, game);
+                std::lock_guard lock(mutex);
+
+                finished.emplace(game, std::move(records));
+
+                for (auto it = finished.begin(); it != finished.end() && it->first == next;
+                     it = finished.erase(it), ++next) {
+                    for (const auto &record : it->second) {
+                        writer.write(record);
+                    }
+
+                    positions += it->second.size();
+                    ++results[static_cast<size_t>(
+                        it->second.empty() ? Game::Result::Unknown : it->second.front().result)];
+                }
+
+                written.notify_all();
+            });
+        }
+    }
+
+    if (!writer.close()) {
+        std::cerr << "Cannot write " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                             .count();
+
+    std::cout << "{\"games\":" << options.games << ",\"positions\":" << positions
+              << ",\"black_wins\":" << results[static_cast<size_t>(Game::Result::BlackWin)]
+              << ",\"white_wins\":" << results[static_cast<size_t>(Game::Result::WhiteWin)]
+              << ",\"draws\":" << results[static_cast<size_t>(Game::Result::Draw)]
+              << ",\"positions_per_second\":" << static_cast<unsigned long long>(positions / seconds)
+              << "}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
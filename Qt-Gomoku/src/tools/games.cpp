@@ -0,0 +1,289 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../game/gamedatabase.h"
+#include "../game/position.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Builds a game database from archives of games, one game per line in the corpus format
+// ("<name> <category> x,y ...", '#' starts a comment), or finds the games reaching a position.
+// Import streams the archives in batches hashed on all cores and appended in input order, the
+// index entries are sorted in runs of --run-mb and merged on disk. A query prints the number
+// of games, the moves played next with their results, and the first --limit games.
+
+namespace {
+constexpr size_t BATCH_SIZE = 4096;
+
+struct Options
+{
+    std::string database = "games.db";
+    std::vector<std::string> inputs;
+    std::string moves;
+    bool query = false;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    size_t runSize = 256;
+    size_t limit = 20;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--database <games.db>] --input <file>|- [--input <file> ...] [--threads <n>]"
+                 " [--run-mb <MB>]\n"
+              << "       " << program
+              << " [--database <games.db>] --moves \"x,y x,y ...\" [--limit <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--database") {
+            options.database = value;
+        } else if (arg == "--input") {
+            options.inputs.push_back(value);
+        } else if (arg == "--moves") {
+            options.moves = value;
+            options.query = true;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--run-mb") {
+            options.runSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--limit") {
+            options.limit = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return options.query != !options.inputs.empty() && options.threads > 0
+           && options.runSize > 0;
+}
+
+const char *toString(const Game::Result &result)
+{
+    switch (result) {
+    case Game::Result::BlackWin:
+        return "black";
+    case Game::Result::WhiteWin:
+        return "white";
+    case Game::Result::Draw:
+        return "draw";
+    default:
+        return "unknown";
+    }
+}
+
+int import(const Options &options)
+{
+    Game::GameDatabaseWriter writer;
+    std::mutex mutex;
+    // Hashed batches waiting for the ones before them.
+    std::map<size_t, Game::GameBatch> ready;
+    size_t next = 0;
+    size_t batches = 0;
+    size_t invalid = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!writer.open(options.database, (options.runSize << 20) / sizeof(Game::GameIndexEntry))) {
+        std::cerr << "Cannot write " << options.database << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    {
+        Algorithm::WorkStealingPool pool(options.threads);
+        std::vector<Game::Position> games;
+
+        const auto submit = [&] {
+            pool.wait(2 * options.threads);
+            pool.submit([&, index = batches++, games = std::move(games)](const size_t &) mutable {
+                auto batch = Game::indexGames(std::move(games));
+                std::lock_guard lock(mutex);
+
+                ready.emplace(index, std::move(batch));
+
+                for (auto it = ready.find(next); it != ready.end(); it = ready.find(next)) {
+                    writer.append(it->second);
+                    ready.erase(it);
+                    ++next;
+                }
+            });
+            games = {};
+        };
+
+        for (const auto &path : options.inputs) {
+            std::ifstream file;
+
+            if (path != "-") {
+                file.open(path);
+
+                if (!file) {
+                    std::cerr << "Cannot open " << path << '\n';
+
+                    return EXIT_FAILURE;
+                }
+            }
+
+            auto &input = path == "-" ? std::cin : file;
+            std::string line;
+
+            while (std::getline(input, line)) {
+                if (const auto first = line.find_first_not_of(" \t\r");
+                    first == std::string::npos || line[first] == '#') {
+                    continue;
+                }
+
+                auto game = Game::parsePosition(line);
+
+                if (!game) {
+                    ++invalid;
+
+                    continue;
+                }
+
+                games.push_back(std::move(*game));
+
+                if (games.size() == BATCH_SIZE) {
+                    submit();
+                }
+            }
+        }
+
+        if (!games.empty()) {
+            submit();
+        }
+    }
+
+    if (!writer.close()) {
+        std::cerr << "Cannot write " << options.database << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "{\"games\":" << writer.games() << ",\"positions\":" << writer.positions()
+              << ",\"skipped\":" << invalid << ",\"time_s\":" << elapsed.count()
+              << ",\"games_per_s\":"
+              << (elapsed.count() > 0 ? writer.games() / elapsed.count() : 0) << "}\n";
+
+    return EXIT_SUCCESS;
+}
+
+struct NextMove
+{
+    Point move{-1, -1};
+    size_t games = 0;
+    size_t blackWins = 0;
+    size_t whiteWins = 0;
+    size_t draws = 0;
+};
+
+int query(const Options &options)
+{
+    const auto position = Game::parsePosition("query query " + options.moves);
+    const auto database = Game::GameDatabase::open(options.database);
+
+    if (!position) {
+        std::cerr << "Invalid moves " << options.moves << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if (!database) {
+        std::cerr << "Cannot open " << options.database << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    Search::Board board{};
+
+    for (size_t i = 0; i < position->moves.size(); ++i) {
+        const auto &[x, y] = position->moves[i];
+
+        board[x][y] = i % 2 ? White : Black;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto hits = database->find(board);
+    std::map<int, NextMove> nextMoves;
+
+    for (const auto &hit : hits) {
+        auto &next = nextMoves[hit.next.x * 15 + hit.next.y];
+
+        next.move = hit.next;
+        ++next.games;
+        next.blackWins += hit.result == Game::Result::BlackWin;
+        next.whiteWins += hit.result == Game::Result::WhiteWin;
+        next.draws += hit.result == Game::Result::Draw;
+    }
+
+    std::vector<NextMove> sorted;
+
+    for (const auto &[cell, next] : nextMoves) {
+        sorted.push_back(next);
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.games > rhs.games;
+    });
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::cout << "{\"games\":" << hits.size() << ",\"time_us\":" << elapsed.count()
+              << ",\"next\":[";
+
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const auto &next = sorted[i];
+
+        std::cout << (i ? "," : "") << "{\"move\":"
+                  << (next.move.x < 0 ? "null" : '"' + Game::toString(next.move) + '"')
+                  << ",\"games\":" << next.games << ",\"black_wins\":" << next.blackWins
+                  << ",\"white_wins\":" << next.whiteWins << ",\"draws\":" << next.draws << "}";
+    }
+
+    std::cout << "],\"hits\":[";
+
+    for (size_t i = 0; i < std::min(options.limit, hits.size()); ++i) {
+        const auto &hit = hits[i];
+
+        std::cout << (i ? "," : "") << "{\"game\":" << hit.game << ",\"name\":\""
+                  << database->name(hit.game) << "\",\"ply\":" << hit.ply
+                  << ",\"result\":\"" << toString(hit.result) << "\"}";
+    }
+
+    std::cout << "]}\n";
+
+    return EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    return options.query ? query(options) : import(options);
+}
@@ -0,0 +1,461 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/evaluator.h"
+#include "../evaluation/nnue.h"
+#include "../evaluation/policy.h"
+#include "../evaluation/weights.h"
+#include "../game/position.h"
+#include "../game/recordfile.h"
+#include "../match/selfplay.h"
+#include "../match/sprt.h"
+#include "../search/engine.h"
+#include "../search/mcts.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays two engine configurations against each other from the opening positions, each opening
+// twice with colours swapped, on all cores, until the SPRT decides or the game limit is hit.
+// Engine configurations are comma separated key=value lists, e.g. "nodes=20000,mc_c=2":
+// depth, time (ms), nodes, mc_c, mc_m, mc_r, null_r, null_depth, futility, move_exp and weights
+// (a weights file), as printed by gomoku-spsa, nnue (a network file evaluating instead), and
+// policy (a policy network file ordering the moves), policy_plies and policy_prune, and book
+// (an opening book file played from while it knows the position), solved (a solved store file
+// of proven results shared by the configuration's engines), symmetry (0 searches the
+// mirrored root moves too) and canonical_hash (1 shares the table entries of mirrored positions).
+// mcts=<threads> plays with the tree search on that many threads instead (cpuct sets its
+// exploration), nodes then counts playouts. Its time is divided among its threads, so that both
+// styles get the same core-seconds per move.
+// With --records, every position of every game after the opening is appended to a record file
+// with the game result, as training data for gomoku-tune.
+
+#ifndef GOMOKU_BENCH_CORPUS
+#define GOMOKU_BENCH_CORPUS "positions.txt"
+#endif
+
+namespace {
+struct Configuration
+{
+    Search::Limits limits;
+    Search::Parameters parameters;
+    Evaluation::Weights weights = Evaluation::defaultWeights();
+    std::shared_ptr<const Evaluation::Network> network;
+    std::shared_ptr<const Evaluation::PolicyNetwork> policy;
+    std::shared_ptr<const Search::OpeningBook> book;
+    std::shared_ptr<Search::SolvedStore> solved;
+    size_t mctsThreads = 0;
+    Search::MctsParameters mctsParameters;
+};
+
+struct Options
+{
+    std::string openings = GOMOKU_BENCH_CORPUS;
+    std::string category = "opening";
+    std::string records;
+    Configuration engines[2];
+    unsigned long long games = 2000;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    size_t hashSize = 16;
+    // MB of evaluation shape caches per worker thread and per tree search thread.
+    size_t cacheSize = 64;
+    double elo0 = 0;
+    double elo1 = 10;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--engine1 <config>] [--engine2 <config>] [--openings <file>]"
+                 " [--category <name>|all] [--games <n>] [--threads <n>] [--hash <MB per engine>]"
+                 " [--cache-mb <MB per thread>] [--elo0 <elo>] [--elo1 <elo>] [--alpha <p>]"
+                 " [--beta <p>] [--records <file>]\n"
+                 "config: comma separated depth=<n>, time=<ms>, nodes=<n>, mc_c=<n>, mc_m=<n>,"
+                 " mc_r=<n>, null_r=<n>, null_depth=<n>, futility=<n>, move_exp=<x>, weights=<file>,"
+                 " nnue=<file>, policy=<file>, policy_plies=<n>, policy_prune=<p>, book=<file>,"
+                 " solved=<file>, symmetry=<0|1>, canonical_hash=<0|1>, mcts=<threads>,"
+                 " cpuct=<x>\n";
+}
+
+bool parseConfiguration(const std::string &text, Configuration &configuration)
+{
+    std::istringstream stream(text);
+    std::string item;
+
+    while (std::getline(stream, item, ',')) {
+        const auto separator = item.find('=');
+
+        if (separator == std::string::npos) {
+            return false;
+        }
+
+        const auto key = item.substr(0, separator);
+
+        if (key == "weights") {
+            const auto weights = Evaluation::loadWeights(item.substr(separator + 1));
+
+            if (!weights) {
+                return false;
+            }
+
+            configuration.weights = *weights;
+
+            continue;
+        }
+
+        if (key == "nnue") {
+            configuration.network = Evaluation::loadNetwork(item.substr(separator + 1));
+
+            if (!configuration.network) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "policy") {
+            configuration.policy = Evaluation::loadPolicy(item.substr(separator + 1));
+
+            if (!configuration.policy) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "book") {
+            configuration.book = Search::OpeningBook::open(item.substr(separator + 1));
+
+            if (!configuration.book) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "solved") {
+            configuration.solved = Search::SolvedStore::open(item.substr(separator + 1));
+
+            if (!configuration.solved) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "policy_prune") {
+            configuration.parameters.policyPrune = std::atof(item.c_str() + separator + 1);
+
+            if (configuration.parameters.policyPrune < 0
+                || configuration.parameters.policyPrune >= 1) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "cpuct") {
+            configuration.mctsParameters.cPuct = std::atof(item.c_str() + separator + 1);
+
+            if (configuration.mctsParameters.cPuct <= 0) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (key == "move_exp") {
+            configuration.parameters.moveCountExponent = std::atof(item.c_str() + separator + 1);
+
+            if (configuration.parameters.moveCountExponent <= 0) {
+                return false;
+            }
+
+            continue;
+        }
+
+        const auto value = std::atoll(item.c_str() + separator + 1);
+
+        if (key == "depth" && value > 0 && value <= 225) {
+            configuration.limits.depth = static_cast<int>(value);
+        } else if (key == "time" && value >= 0) {
+            configuration.limits.time = std::chrono::milliseconds(value);
+        } else if (key == "nodes" && value >= 0) {
+            configuration.limits.nodes = value;
+        } else if (key == "mc_c" && value > 0) {
+            configuration.parameters.multiCutC = static_cast<int>(value);
+        } else if (key == "mc_m" && value > 0) {
+            configuration.parameters.multiCutM = static_cast<int>(value);
+        } else if (key == "mc_r" && value >= 0) {
+            configuration.parameters.multiCutR = static_cast<int>(value);
+        } else if (key == "null_r" && value >= 0) {
+            configuration.parameters.nullMoveR = static_cast<int>(value);
+        } else if (key == "null_depth" && value >= 0) {
+            configuration.parameters.nullMoveDepth = static_cast<int>(value);
+        } else if (key == "futility" && value >= 0) {
+            configuration.parameters.futilityMargin = static_cast<int>(value);
+        } else if (key == "policy_plies" && value >= 0) {
+            configuration.parameters.policyPlies = static_cast<int>(value);
+        } else if (key == "symmetry" && (value == 0 || value == 1)) {
+            configuration.parameters.rootSymmetry = value;
+        } else if (key == "canonical_hash" && (value == 0 || value == 1)) {
+            configuration.parameters.canonicalHash = value;
+        } else if (key == "mcts" && value > 0) {
+            configuration.mctsThreads = static_cast<size_t>(value);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (auto &engine : options.engines) {
+        engine.limits.depth = 225;
+        engine.limits.nodes = 20000;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--engine1" || arg == "--engine2") {
+            if (!parseConfiguration(value, options.engines[arg == "--engine2"])) {
+                return false;
+            }
+        } else if (arg == "--openings") {
+            options.openings = value;
+        } else if (arg == "--category") {
+            options.category = value;
+        } else if (arg == "--records") {
+            options.records = value;
+        } else if (arg == "--games") {
+            options.games = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--hash") {
+            options.hashSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--cache-mb") {
+            options.cacheSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--elo0") {
+            options.elo0 = std::atof(value.c_str());
+        } else if (arg == "--elo1") {
+            options.elo1 = std::atof(value.c_str());
+        } else if (arg == "--alpha") {
+            options.alpha = std::atof(value.c_str());
+        } else if (arg == "--beta") {
+            options.beta = std::atof(value.c_str());
+        } else {
+            return false;
+        }
+    }
+
+    for (auto &engine : options.engines) {
+        if (engine.mctsThreads && engine.limits.time.count() > 0) {
+            const auto threads = static_cast<std::chrono::milliseconds::rep>(engine.mctsThreads);
+
+            engine.limits.time = std::max(std::chrono::milliseconds(1),
+                                          engine.limits.time / threads);
+        }
+    }
+
+    return options.games > 0 && options.threads > 0 && options.hashSize > 0
+           && options.cacheSize > 0 && options.elo0 < options.elo1 && options.alpha > 0 && options.alpha < 1
+           && options.beta > 0 && options.beta < 1;
+}
+
+void printTally(std::ostream &stream,
+                const Match::Tally &tally,
+                const Match::Sprt &sprt,
+                const double &hours)
+{
+    stream << "\"games\":" << tally.games() << ",\"wins\":" << tally.wins
+           << ",\"draws\":" << tally.draws << ",\"losses\":" << tally.losses << std::fixed
+           << std::setprecision(1) << ",\"elo\":" << tally.elo()
+           << ",\"elo_error\":" << tally.eloError() << std::setprecision(3)
+           << ",\"llr\":" << sprt.llr(tally) << ",\"llr_lower\":" << sprt.lowerBound()
+           << ",\"llr_upper\":" << sprt.upperBound() << std::setprecision(1)
+           << ",\"games_per_hour\":" << (hours > 0 ? tally.games() / hours : 0.0)
+           << std::defaultfloat;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    auto positions = Game::loadPositions(options.openings);
+
+    if (!positions) {
+        std::cerr << "Cannot load the openings " << options.openings << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if (options.category != "all") {
+        positions->erase(std::remove_if(positions->begin(),
+                                        positions->end(),
+                                        [&options](const auto &position) {
+                                            return position.category != options.category;
+                                        }),
+                         positions->end());
+    }
+
+    if (positions->empty()) {
+        std::cerr << "No opening positions\n";
+
+        return EXIT_FAILURE;
+    }
+
+    // One engine per configuration per worker, both follow every game of the worker.
+    std::vector<std::array<std::unique_ptr<Search::Engine>, 2>> engines(options.threads);
+
+    for (auto &pair : engines) {
+        for (size_t i = 0; i < 2; ++i) {
+            pair[i] = std::make_unique<Search::Engine>(options.hashSize << 20);
+            pair[i]->setParameters(options.engines[i].parameters);
+            pair[i]->setWeights(options.engines[i].weights);
+            pair[i]->setNetwork(options.engines[i].network);
+            pair[i]->setPolicy(options.engines[i].policy);
+            pair[i]->setBook(options.engines[i].book);
+            pair[i]->setSolvedStore(options.engines[i].solved);
+        }
+    }
+
+    // The tree searches of the mcts configurations, next to the engines that referee.
+    std::vector<std::array<std::unique_ptr<Search::MctsEngine>, 2>> trees(options.threads);
+
+    for (auto &pair : trees) {
+        for (size_t i = 0; i < 2; ++i) {
+            if (const auto &configuration = options.engines[i]; configuration.mctsThreads) {
+                pair[i] = std::make_unique<Search::MctsEngine>(configuration.mctsThreads,
+                                                               options.hashSize << 20);
+                pair[i]->setParameters(configuration.mctsParameters);
+                pair[i]->setWeights(configuration.weights);
+                pair[i]->setNetwork(configuration.network);
+                pair[i]->setPolicy(configuration.policy);
+                pair[i]->setCacheSize(options.cacheSize << 20);
+            }
+        }
+    }
+
+    Game::RecordWriter writer;
+
+    if (!options.records.empty() && !writer.open(options.records, true)) {
+        std::cerr << "Cannot open " << options.records << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    const Match::Sprt sprt(options.elo0, options.elo1, options.alpha, options.beta);
+    const auto start = std::chrono::steady_clock::now();
+    std::mutex mutex;
+    std::atomic<bool> decided = false;
+    Match::Tally tally;
+
+    const auto hours = [&start] {
+        return std::chrono::duration<double, std::ratio<3600>>(std::chrono::steady_clock::now()
+                                                               - start)
+            .count();
+    };
+
+    {
+        Algorithm::WorkStealingPool pool(options.threads);
+
+        for (unsigned long long game = 0; game < options.games && !decided; ++game) {
+            pool.wait(2 * options.threads);
+            pool.submit([&, game](const size_t &worker) {
+                if (decided) {
+                    return;
+                }
+
+                Evaluation::Evaluator::setCacheSize(options.cacheSize << 20);
+
+                // Engine 1 plays black in even games, white in odd ones, from the same opening.
+                const auto &opening = (*positions)[game / 2 % positions->size()].moves;
+                const auto first = game % 2;
+                const Match::Player black{engines[worker][first].get(),
+                                          options.engines[first].limits,
+                                          trees[worker][first].get()};
+                const Match::Player white{engines[worker][1 - first].get(),
+                                          options.engines[1 - first].limits,
+                                          trees[worker][1 - first].get()};
+                std::vector<Point> moves;
+                const auto result = Match::play(black, white, opening, &moves);
+                std::lock_guard lock(mutex);
+
+                if (decided) {
+                    return;
+                }
+
+                if (!options.records.empty()) {
+                    Game::Position position{"", "", opening};
+
+                    for (size_t i = opening.size(); i < moves.size(); ++i) {
+                        auto record = Game::toRecord(position);
+
+                        record.result = result;
+                        writer.write(record);
+                        position.moves.push_back(moves[i]);
+                    }
+                }
+
+                if (result == Game::Result::Draw) {
+                    ++tally.draws;
+                } else if ((result == Game::Result::BlackWin) == !first) {
+                    ++tally.wins;
+                } else {
+                    ++tally.losses;
+                }
+
+                decided = sprt.decide(tally) != Match::Sprt::Continue;
+
+                std::cerr << '{';
+                printTally(std::cerr, tally, sprt, hours());
+                std::cerr << '}' << std::endl;
+            });
+        }
+    }
+
+    if (!options.records.empty() && !writer.close()) {
+        std::cerr << "Cannot write " << options.records << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    const auto decision = sprt.decide(tally);
+
+    std::cout << "{\"result\":\""
+              << (decision == Match::Sprt::AcceptH1   ? "H1"
+                  : decision == Match::Sprt::AcceptH0 ? "H0"
+                                                      : "inconclusive")
+              << "\",";
+    printTally(std::cout, tally, sprt, hours());
+    std::cout << '}' << std::endl;
+
+    return EXIT_SUCCESS;
+}
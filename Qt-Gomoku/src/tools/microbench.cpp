@@ -0,0 +1,402 @@
+#include "../evaluation/evaluator.h"
+#include "../game/movesgenerator.h"
+#include "../game/position.h"
+#include "../search/engine.h"
+#include "../search/transpositiontable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Times the evaluator, moves generator and transposition table in isolation, on corpus
+// positions and on random playouts from them, and reports ns/op and allocations/op.
+
+#ifndef GOMOKU_BENCH_CORPUS
+#define GOMOKU_BENCH_CORPUS "positions.txt"
+#endif
+
+namespace {
+unsigned long long allocations = 0;
+}
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace {
+struct Result
+{
+    std::chrono::nanoseconds time{0};
+    unsigned long long allocations = 0;
+    unsigned long long ops = 0;
+};
+
+class Timer
+{
+private:
+    Result &result;
+    std::chrono::steady_clock::time_point start;
+    unsigned long long startAllocations;
+    unsigned long long ops;
+
+public:
+    Timer(Result &result, const unsigned long long &ops)
+        : result(result)
+        , start(std::chrono::steady_clock::now())
+        , startAllocations(allocations)
+        , ops(ops)
+    {}
+
+    ~Timer()
+    {
+        result.time += std::chrono::steady_clock::now() - start;
+        result.allocations += allocations - startAllocations;
+        result.ops += ops;
+    }
+};
+
+// The board and shape lines Engine keeps for its evaluator and moves generator.
+struct Fixture
+{
+    std::array<std::array<Stone, 15>, 15> board{};
+    std::array<std::string, 72> blackShapes;
+    std::array<std::string, 72> whiteShapes;
+    Evaluation::Evaluator evaluator{&blackShapes, &whiteShapes};
+    Game::MovesGenerator generator{&evaluator, &board};
+
+    Fixture()
+    {
+        std::fill_n(blackShapes.begin(), 30, std::string(15, '0'));
+        std::fill_n(whiteShapes.begin(), 30, std::string(15, '0'));
+
+        for (int i = 5; i <= 15; ++i) {
+            blackShapes[25 + i] = whiteShapes[25 + i] = std::string(i, '0');
+            blackShapes[35 + i] = whiteShapes[35 + i] = std::string(20 - i, '0');
+            blackShapes[46 + i] = whiteShapes[46 + i] = std::string(i, '0');
+            blackShapes[56 + i] = whiteShapes[56 + i] = std::string(20 - i, '0');
+        }
+    }
+
+    void write(const Point &point, const char &black, const char &white)
+    {
+        const auto &[x, y] = point;
+
+        blackShapes[y][x] = black;
+        whiteShapes[y][x] = white;
+        blackShapes[x + 15][y] = black;
+        whiteShapes[x + 15][y] = white;
+
+        if (std::abs(y - x) <= 10) {
+            blackShapes[y - x + 40][std::min(x, y)] = black;
+            whiteShapes[y - x + 40][std::min(x, y)] = white;
+        }
+
+        if (x + y >= 4 && x + y <= 24) {
+            blackShapes[x + y + 47][std::min(y, 14 - x)] = black;
+            whiteShapes[x + y + 47][std::min(y, 14 - x)] = white;
+        }
+    }
+
+    void place(const Point &point, const Stone &stone)
+    {
+        write(point, stone == Black ? '1' : '2', stone == Black ? '2' : '1');
+        board[point.x][point.y] = stone;
+    }
+
+    void remove(const Point &point)
+    {
+        write(point, '0', '0');
+        board[point.x][point.y] = Empty;
+    }
+
+    void move(const Point &point, const Stone &stone)
+    {
+        place(point, stone);
+        evaluator.update(point);
+        generator.move(point);
+    }
+
+    std::vector<Point> candidates() const
+    {
+        std::vector<Point> points;
+
+        for (const auto &[point, _] : generator.generate()) {
+            points.push_back(point);
+        }
+
+        std::sort(points.begin(), points.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.x == rhs.x ? lhs.y < rhs.y : lhs.x < rhs.x;
+        });
+
+        return points;
+    }
+};
+
+std::vector<Point> playout(const Fixture &fixture,
+                           Stone stone,
+                           const int &length,
+                           std::mt19937 &random)
+{
+    Fixture copy;
+    std::vector<Point> moves;
+
+    copy.board = fixture.board;
+    copy.blackShapes = fixture.blackShapes;
+    copy.whiteShapes = fixture.whiteShapes;
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            if (copy.board[x][y] != Empty) {
+                copy.generator.move({x, y});
+            }
+        }
+    }
+
+    for (int i = 0; i < length; ++i) {
+        const auto candidates = copy.candidates();
+
+        if (candidates.empty()) {
+            break;
+        }
+
+        const auto move = candidates[random() % candidates.size()];
+
+        copy.place(move, stone);
+        moves.push_back(move);
+        stone = static_cast<Stone>(-stone);
+    }
+
+    return moves;
+}
+
+void report(const std::string &name, const Result &result)
+{
+    const auto ops = std::max(1ULL, result.ops);
+
+    std::cout << "{\"benchmark\":\"" << name << "\",\"ops\":" << result.ops << ",\"ns_per_op\":"
+              << std::fixed << std::setprecision(1)
+              << static_cast<double>(result.time.count()) / ops << ",\"allocs_per_op\":"
+              << std::setprecision(3) << static_cast<double>(result.allocations) / ops << "}"
+              << std::defaultfloat << std::endl;
+}
+
+void benchEvaluatorAndGenerator(const std::vector<Game::Position> &positions, const int &rounds)
+{
+    std::map<std::string, Result> results;
+    std::mt19937 random(20240607);
+
+    for (const auto &position : positions) {
+        Fixture fixture;
+        auto stone = Black;
+
+        for (const auto &move : position.moves) {
+            fixture.move(move, stone);
+            stone = static_cast<Stone>(-stone);
+        }
+
+        const auto candidates = fixture.candidates();
+
+        for (int round = 0; round < rounds; ++round) {
+            {
+                Timer timer(results["evaluator.evaluateMove"], candidates.size() * 4);
+
+                for (const auto &candidate : candidates) {
+                    for (int d = 0; d < 4; ++d) {
+                        [[maybe_unused]] const auto scores = fixture.evaluator.evaluateMove(candidate,
+                                                                                            d);
+                    }
+                }
+            }
+
+            {
+                Timer timer(results["evaluator.isFourMove"], candidates.size());
+
+                for (const auto &candidate : candidates) {
+                    [[maybe_unused]] const auto four = fixture.evaluator.isFourMove(candidate, stone);
+                }
+            }
+
+            {
+                Timer timer(results["generator.generate"], 1);
+
+                [[maybe_unused]] const auto moves = fixture.generator.generate();
+            }
+
+            const auto moves = playout(fixture, stone, 10, random);
+            auto playoutStone = stone;
+
+            // Shape lines are written outside of the timed blocks, as Engine::move does.
+            for (const auto &move : moves) {
+                fixture.place(move, playoutStone);
+
+                {
+                    Timer timer(results["evaluator.update"], 1);
+
+                    fixture.evaluator.update(move);
+                }
+
+                {
+                    Timer timer(results["generator.move"], 1);
+
+                    fixture.generator.move(move);
+                }
+
+                playoutStone = static_cast<Stone>(-playoutStone);
+            }
+
+            for (auto it = moves.crbegin(); it != moves.crend(); ++it) {
+                {
+                    Timer timer(results["generator.undo"], 1);
+
+                    fixture.generator.undo(*it);
+                }
+
+                fixture.remove(*it);
+
+                {
+                    Timer timer(results["evaluator.restore"], 1);
+
+                    fixture.evaluator.restore();
+                }
+            }
+        }
+    }
+
+    for (const auto &[name, result] : results) {
+        report(name, result);
+    }
+}
+
+void benchTranspositionTable(const size_t &hashSize)
+{
+    constexpr auto operations = 1 << 20;
+
+    std::mt19937_64 random(20240607);
+
+    for (const auto fill : {0.0, 0.25, 0.5, 1.0, 4.0}) {
+        Search::TranspositionTable table(hashSize);
+        const auto capacity = table.size() / sizeof(Search::HashEntry);
+        const auto count = static_cast<size_t>(fill * capacity);
+        std::vector<unsigned long long> keys(count);
+        Result insert;
+        Result probeHit;
+        Result probeMiss;
+
+        for (auto &key : keys) {
+            key = random();
+            table.insert(key, Search::HashEntry::Exact, {7, 7}, 4, 0, Black);
+        }
+
+        std::vector<unsigned long long> newKeys(operations);
+
+        for (auto &key : newKeys) {
+            key = random();
+        }
+
+        {
+            Point move{-1, -1};
+            Timer timer(probeMiss, operations);
+
+            for (const auto &key : newKeys) {
+                [[maybe_unused]] const auto score = table.probe(key, Min, Max, 1, Black, move);
+            }
+        }
+
+        if (!keys.empty()) {
+            Point move{-1, -1};
+            Timer timer(probeHit, operations);
+
+            for (int i = 0; i < operations; ++i) {
+                [[maybe_unused]] const auto score
+                    = table.probe(keys[random() % keys.size()], Min, Max, 1, Black, move);
+            }
+        }
+
+        {
+            Timer timer(insert, operations);
+
+            for (const auto &key : newKeys) {
+                table.insert(key, Search::HashEntry::LowerBound, {7, 8}, 3, 10, White);
+            }
+        }
+
+        const auto suffix = "@" + std::to_string(static_cast<int>(fill * 100)) + "%";
+
+        report("tt.insert" + suffix, insert);
+        report("tt.probe_miss" + suffix, probeMiss);
+
+        if (!keys.empty()) {
+            report("tt.probe" + suffix, probeHit);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string corpus = GOMOKU_BENCH_CORPUS;
+    size_t hashSize = 64;
+    int rounds = 3;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (const std::string arg = argv[i]; arg == "--corpus") {
+            corpus = argv[i + 1];
+        } else if (arg == "--hash") {
+            hashSize = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (arg == "--rounds") {
+            rounds = std::atoi(argv[i + 1]);
+        }
+    }
+
+    const auto positions = Game::loadPositions(corpus);
+
+    if (argc % 2 == 0 || !positions || hashSize == 0 || rounds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [--corpus <file>] [--hash <MB>] [--rounds <n>]\n";
+
+        return EXIT_FAILURE;
+    }
+
+    benchEvaluatorAndGenerator(*positions, rounds);
+    benchTranspositionTable(hashSize << 20);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/nnue.h"
+#include "../game/recordfile.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trains the network of evaluation/nnue.h on record files and writes it quantized.
+// The float network predicts sigmoid(score / scale): the target mixes the record's search
+// score and game result, both from the side to move's point of view. Every epoch sees each
+// position under a random one of the 8 board symmetries. One record in 20 is held out.
+
+namespace {
+using Evaluation::NNUE_HIDDEN;
+using Evaluation::NNUE_INPUTS;
+
+struct Options
+{
+    std::string data;
+    std::string output = "network.nnue";
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    int epochs = 20;
+    size_t batch = 4096;
+    double rate = 0.001;
+    double scale = 600;
+    double lambda = 0.5;
+    unsigned long long seed = 1;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " --data <records.bin> [--output <network.nnue>] [--threads <n>] [--epochs <n>]"
+                 " [--batch <n>] [--rate <r>] [--scale <score>] [--lambda <score weight>]"
+                 " [--seed <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--data") {
+            options.data = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--epochs") {
+            options.epochs = std::atoi(value.c_str());
+        } else if (arg == "--batch") {
+            options.batch = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (arg == "--scale") {
+            options.scale = std::atof(value.c_str());
+        } else if (arg == "--lambda") {
+            options.lambda = std::atof(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return !options.data.empty() && options.threads > 0 && options.epochs >= 0
+           && options.batch > 0 && options.rate > 0 && options.scale > 0
+           && options.scale <= Evaluation::NNUE_MAX_SCALE && options.lambda >= 0
+           && options.lambda <= 1;
+}
+
+double sigmoid(const double &x)
+{
+    return 1 / (1 + std::exp(-x));
+}
+
+// The 8 symmetries of the board, bit 2 mirrors, bits 0-1 rotate a quarter turn each.
+Point transform(Point point, const int &symmetry)
+{
+    if (symmetry & 4) {
+        point.x = 14 - point.x;
+    }
+
+    for (int i = 0; i < (symmetry & 3); ++i) {
+        point = {point.y, 14 - point.x};
+    }
+
+    return point;
+}
+
+struct Sample
+{
+    std::vector<Point> black;
+    std::vector<Point> white;
+    Stone side;
+    float target;
+};
+
+// The float network, and its gradients and Adam moments in the same flat layout.
+constexpr size_t FEATURE_BIASES = NNUE_INPUTS * NNUE_HIDDEN;
+constexpr size_t OUTPUT_WEIGHTS = FEATURE_BIASES + NNUE_HIDDEN;
+constexpr size_t OUTPUT_BIAS = OUTPUT_WEIGHTS + 2 * NNUE_HIDDEN;
+constexpr size_t PARAMETER_COUNT = OUTPUT_BIAS + 1;
+
+using Parameters = std::vector<float>;
+
+// Squared error of one sample, and its gradient added to gradient when given.
+double train(const Parameters &network,
+             const Sample &sample,
+             const int &symmetry,
+             Parameters *gradient)
+{
+    std::array<std::vector<int>, 2> features;
+    std::array<std::array<float, NNUE_HIDDEN>, 2> hidden;
+    const std::array<Stone, 2> perspectives = {sample.side, static_cast<Stone>(-sample.side)};
+    double output = network[OUTPUT_BIAS];
+
+    for (size_t p = 0; p < 2; ++p) {
+        std::copy_n(&network[FEATURE_BIASES], NNUE_HIDDEN, hidden[p].begin());
+
+        for (const auto stone : {Black, White}) {
+            for (const auto &point : stone == Black ? sample.black : sample.white) {
+                const auto feature = Evaluation::nnueFeature(transform(point, symmetry),
+                                                             stone,
+                                                             perspectives[p]);
+                const auto *row = &network[feature * NNUE_HIDDEN];
+
+                features[p].push_back(feature);
+
+                for (int i = 0; i < NNUE_HIDDEN; ++i) {
+                    hidden[p][i] += row[i];
+                }
+            }
+        }
+
+        for (int i = 0; i < NNUE_HIDDEN; ++i) {
+            output += network[OUTPUT_WEIGHTS + p * NNUE_HIDDEN + i]
+                      * std::clamp(hidden[p][i], 0.0F, 1.0F);
+        }
+    }
+
+    const auto prediction = sigmoid(output);
+    const auto difference = prediction - sample.target;
+
+    if (gradient) {
+        const auto factor = static_cast<float>(2 * difference * prediction * (1 - prediction));
+
+        (*gradient)[OUTPUT_BIAS] += factor;
+
+        for (size_t p = 0; p < 2; ++p) {
+            std::array<float, NNUE_HIDDEN> delta;
+
+            for (int i = 0; i < NNUE_HIDDEN; ++i) {
+                const auto active = hidden[p][i] > 0 && hidden[p][i] < 1;
+
+                (*gradient)[OUTPUT_WEIGHTS + p * NNUE_HIDDEN + i]
+                    += factor * std::clamp(hidden[p][i], 0.0F, 1.0F);
+                delta[i] = active ? factor * network[OUTPUT_WEIGHTS + p * NNUE_HIDDEN + i] : 0;
+                (*gradient)[FEATURE_BIASES + i] += delta[i];
+            }
+
+            for (const auto feature : features[p]) {
+                auto *row = &(*gradient)[feature * NNUE_HIDDEN];
+
+                for (int i = 0; i < NNUE_HIDDEN; ++i) {
+                    row[i] += delta[i];
+                }
+            }
+        }
+    }
+
+    return difference * difference;
+}
+
+std::unique_ptr<Evaluation::Network> quantize(const Parameters &parameters, const double &scale)
+{
+    auto network = std::make_unique<Evaluation::Network>();
+
+    const auto toInt16 = [](const double &value) {
+        return static_cast<std::int16_t>(std::clamp(std::lround(value), -32767L, 32767L));
+    };
+
+    for (int feature = 0; feature < NNUE_INPUTS; ++feature) {
+        for (int i = 0; i < NNUE_HIDDEN; ++i) {
+            network->featureWeights[feature][i] = toInt16(parameters[feature * NNUE_HIDDEN + i]
+                                                          * Evaluation::NNUE_QA);
+        }
+    }
+
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        network->featureBiases[i] = toInt16(parameters[FEATURE_BIASES + i] * Evaluation::NNUE_QA);
+    }
+
+    for (int i = 0; i < 2 * NNUE_HIDDEN; ++i) {
+        network->outputWeights[i] = toInt16(parameters[OUTPUT_WEIGHTS + i] * Evaluation::NNUE_QB);
+    }
+
+    network->outputBias = static_cast<std::int32_t>(
+        std::lround(parameters[OUTPUT_BIAS] * Evaluation::NNUE_QA * Evaluation::NNUE_QB));
+    network->scale = static_cast<std::int32_t>(std::lround(scale));
+
+    return network;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Game::RecordReader reader;
+
+    if (!reader.open(options.data)) {
+        std::cerr << "Cannot open " << options.data << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Sample> training;
+    std::vector<Sample> validation;
+
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const auto &record = reader[i];
+
+        if (record.result == Game::Result::Unknown) {
+            continue;
+        }
+
+        Sample sample;
+
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                if (const auto stone = record.stone({x, y}); stone != Empty) {
+                    (stone == Black ? sample.black : sample.white).push_back({x, y});
+                }
+            }
+        }
+
+        const auto side = record.side();
+        const auto winner = record.result == Game::Result::BlackWin   ? Black
+                            : record.result == Game::Result::WhiteWin ? White
+                                                                      : Empty;
+        const auto result = winner == Empty ? 0.5 : winner == side ? 1.0 : 0.0;
+
+        sample.side = side;
+        sample.target = static_cast<float>(options.lambda
+                                               * sigmoid(record.scoreValue() / options.scale)
+                                           + (1 - options.lambda) * result);
+
+        (i % 20 == 19 ? validation : training).push_back(std::move(sample));
+    }
+
+    if (training.empty()) {
+        std::cerr << "No record with a result\n";
+
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937_64 random(options.seed);
+    std::uniform_real_distribution<float> initial(-0.1F, 0.1F);
+    Parameters network(PARAMETER_COUNT);
+    Parameters mean(PARAMETER_COUNT);
+    Parameters variance(PARAMETER_COUNT);
+    Parameters gradient(PARAMETER_COUNT);
+    std::vector<Parameters> gradients(options.threads, Parameters(PARAMETER_COUNT));
+    Algorithm::WorkStealingPool pool(options.threads);
+
+    // Hidden units start half open, the output starts small.
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+        network[i] = i >= FEATURE_BIASES && i < OUTPUT_WEIGHTS ? 0.5F
+                     : i == OUTPUT_BIAS                        ? 0.0F
+                                                               : initial(random);
+    }
+
+    const auto validate = [&] {
+        double error = 0;
+
+        for (const auto &sample : validation) {
+            error += train(network, sample, 0, nullptr);
+        }
+
+        return validation.empty() ? 0 : error / validation.size();
+    };
+
+    std::cerr << training.size() << " training and " << validation.size()
+              << " validation positions, validation error " << validate() << '\n';
+
+    std::vector<size_t> order(training.size());
+    std::vector<int> symmetries(training.size());
+    unsigned long long step = 0;
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        double error = 0;
+
+        std::shuffle(order.begin(), order.end(), random);
+
+        for (auto &symmetry : symmetries) {
+            symmetry = static_cast<int>(random() % 8);
+        }
+
+        for (size_t begin = 0; begin < order.size(); begin += options.batch) {
+            const auto end = std::min(order.size(), begin + options.batch);
+            const auto chunk = (end - begin + options.threads - 1) / options.threads;
+            std::vector<double> errors(options.threads);
+
+            for (size_t t = 0; t < options.threads; ++t) {
+                pool.submit([&, t](const size_t &) {
+                    const auto last = std::min(end, begin + (t + 1) * chunk);
+
+                    std::fill(gradients[t].begin(), gradients[t].end(), 0.0F);
+
+                    for (auto i = begin + t * chunk; i < last; ++i) {
+                        errors[t] += train(network,
+                                           training[order[i]],
+                                           symmetries[order[i]],
+                                           &gradients[t]);
+                    }
+                });
+            }
+
+            pool.wait();
+            std::fill(gradient.begin(), gradient.end(), 0.0F);
+
+            for (size_t t = 0; t < options.threads; ++t) {
+                error += errors[t];
+
+                for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+                    gradient[i] += gradients[t][i];
+                }
+            }
+
+            // Adam on the batch mean gradient.
+            ++step;
+
+            const auto size = static_cast<float>(end - begin);
+            const auto meanCorrection = static_cast<float>(1 - std::pow(0.9, step));
+            const auto varianceCorrection = static_cast<float>(1 - std::pow(0.999, step));
+
+            for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+                const auto g = gradient[i] / size;
+
+                mean[i] = 0.9F * mean[i] + 0.1F * g;
+                variance[i] = 0.999F * variance[i] + 0.001F * g * g;
+                network[i] -= static_cast<float>(options.rate) * (mean[i] / meanCorrection)
+                              / (std::sqrt(variance[i] / varianceCorrection) + 1e-8F);
+                // Keeps the quantized weights inside int16.
+                network[i] = std::clamp(network[i], -127.0F, 127.0F);
+            }
+        }
+
+        std::cerr << "epoch " << epoch << ", training error " << error / training.size()
+                  << ", validation error " << validate() << '\n';
+    }
+
+    if (!Evaluation::saveNetwork(options.output, *quantize(network, options.scale))) {
+        std::cerr << "Cannot write " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
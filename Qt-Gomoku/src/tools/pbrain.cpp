@@ -0,0 +1,294 @@
+#include "../evaluation/evaluator.h"
+#include "../evaluation/weights.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Piskvork / Gomocup protocol frontend over stdin and stdout.
+// https://plastovicka.github.io/protocl2en.htm
+
+namespace {
+constexpr size_t DEFAULT_HASH_SIZE = 1 << 29;
+// timeout_turn 0 asks for a move as fast as possible.
+constexpr std::chrono::milliseconds FAST_TIME{10};
+
+struct Brain
+{
+    // Made on the first move, after the INFO lines following START set the memory limit.
+    std::unique_ptr<Search::Engine> engine;
+    bool started = false;
+    Evaluation::Weights weights = Evaluation::defaultWeights();
+    size_t hashSize = DEFAULT_HASH_SIZE;
+    long long timeoutTurn = 30000;
+    long long timeoutMatch = 0;
+    // -1 until the manager sends time_left.
+    long long timeLeft = -1;
+    Stone own = Empty;
+};
+
+bool parsePoint(const std::string &text, Point &point)
+{
+    char comma;
+    std::istringstream stream(text);
+
+    return stream >> point.x >> comma >> point.y && comma == ',';
+}
+
+Search::Engine &engine(Brain &brain)
+{
+    if (!brain.engine) {
+        brain.engine = std::make_unique<Search::Engine>(brain.hashSize);
+        brain.engine->setWeights(brain.weights);
+    }
+
+    return *brain.engine;
+}
+
+// A new game keeps the engine and its table size, only the board and the tables are emptied.
+void restart(Brain &brain)
+{
+    if (brain.engine) {
+        while (brain.engine->lastMove().x >= 0) {
+            brain.engine->undo(1);
+        }
+
+        brain.engine->clearHash();
+    }
+
+    brain.own = Empty;
+}
+
+std::chrono::milliseconds budget(const Brain &brain)
+{
+    if (brain.timeoutTurn == 0) {
+        return FAST_TIME;
+    }
+
+    long long time = brain.timeoutTurn > 0 ? brain.timeoutTurn : 1000;
+
+    if (brain.timeoutMatch > 0 && brain.timeLeft >= 0) {
+        // Assume about 15 more moves of ours, the board fills up before most games end.
+        time = std::min(time, brain.timeLeft / 15);
+    }
+
+    // Leave room for the process and pipe overhead and the deadline check granularity.
+    return std::chrono::milliseconds(std::max(1LL, time - std::max(30LL, time / 10)));
+}
+
+void think(Brain &brain)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Search::Limits limits;
+
+    limits.time = budget(brain);
+
+    const auto move = engine(brain).bestMove(brain.own, limits);
+
+    engine(brain).move(move, brain.own);
+
+    if (brain.timeoutMatch > 0 && brain.timeLeft >= 0) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        brain.timeLeft = std::max(0LL, brain.timeLeft - elapsed.count());
+    }
+
+    std::cout << move.x << ',' << move.y << std::endl;
+}
+
+void info(Brain &brain, std::istringstream &stream)
+{
+    std::string key;
+    long long value = 0;
+
+    if (!(stream >> key >> value)) {
+        return;
+    }
+
+    if (key == "timeout_turn") {
+        brain.timeoutTurn = value;
+    } else if (key == "timeout_match") {
+        brain.timeoutMatch = value;
+    } else if (key == "time_left") {
+        brain.timeLeft = value;
+    } else if (key == "max_memory") {
+        // Half of the memory limit goes to the transposition tables and three eighths to the
+        // shape caches of this thread, the rest is left to the process.
+        brain.hashSize = value > 0 ? static_cast<size_t>(value) / 2 : DEFAULT_HASH_SIZE;
+
+        if (value > 0) {
+            Evaluation::Evaluator::setCacheSize(static_cast<size_t>(value) / 8 * 3);
+        }
+
+        if (brain.engine) {
+            brain.engine->setHashSize(brain.hashSize);
+        }
+    }
+}
+
+bool place(Brain &brain, const Point &point, const Stone &stone)
+{
+    if (!Search::Engine::isLegal(point) || engine(brain).checkStone(point) != Empty) {
+        return false;
+    }
+
+    engine(brain).move(point, stone);
+
+    return true;
+}
+
+void board(Brain &brain)
+{
+    struct Field
+    {
+        Point point;
+        int owner;
+    };
+
+    std::vector<Field> fields;
+    std::string line;
+    int ownCount = 0;
+    int opponentCount = 0;
+
+    while (std::getline(std::cin, line) && line.rfind("DONE", 0) != 0) {
+        char comma;
+        Field field{};
+        std::istringstream stream(line);
+
+        if (stream >> field.point.x >> comma >> field.point.y >> comma >> field.owner) {
+            fields.push_back(field);
+            ownCount += field.owner == 1;
+            opponentCount += field.owner == 2;
+        }
+    }
+
+    restart(brain);
+
+    brain.own = ownCount == opponentCount ? Black : White;
+
+    for (const auto &[point, owner] : fields) {
+        if (owner == 1 || owner == 2) {
+            const auto stone = owner == 1 ? brain.own : static_cast<Stone>(-brain.own);
+
+            if (!place(brain, point, stone)) {
+                std::cout << "ERROR invalid board" << std::endl;
+
+                return;
+            }
+        }
+    }
+
+    think(brain);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Brain brain;
+    std::string line;
+
+    for (int i = 1; i < argc; ++i) {
+        if (const std::string arg = argv[i]; arg == "--weights" && i + 1 < argc) {
+            const auto weights = Evaluation::loadWeights(argv[++i]);
+
+            if (!weights) {
+                std::cerr << "Cannot load weights from " << argv[i] << '\n';
+
+                return EXIT_FAILURE;
+            }
+
+            brain.weights = *weights;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--weights <file>]\n";
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        std::istringstream stream(line);
+        std::string command;
+
+        if (!(stream >> command)) {
+            continue;
+        }
+
+        std::transform(command.begin(), command.end(), command.begin(), [](const auto &c) {
+            return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        });
+
+        if (command == "END") {
+            break;
+        }
+
+        if (command == "START") {
+            if (int size = 0; stream >> size && size == 15) {
+                brain.started = true;
+                restart(brain);
+
+                std::cout << "OK" << std::endl;
+            } else {
+                std::cout << "ERROR unsupported size" << std::endl;
+            }
+        } else if (command == "ABOUT") {
+            std::cout << "name=\"Qt-Gomoku\", version=\"1.0\", author=\"SXKA\"" << std::endl;
+        } else if (command == "INFO") {
+            info(brain, stream);
+        } else if (!brain.started) {
+            std::cout << "ERROR no START" << std::endl;
+        } else if (command == "RESTART") {
+            restart(brain);
+
+            std::cout << "OK" << std::endl;
+        } else if (command == "BEGIN") {
+            brain.own = Black;
+
+            think(brain);
+        } else if (command == "TURN") {
+            std::string text;
+            Point point{};
+
+            if (brain.own == Empty) {
+                brain.own = White;
+            }
+
+            if (!(stream >> text) || !parsePoint(text, point)
+                || !place(brain, point, static_cast<Stone>(-brain.own))) {
+                std::cout << "ERROR invalid move" << std::endl;
+
+                continue;
+            }
+
+            think(brain);
+        } else if (command == "BOARD") {
+            board(brain);
+        } else if (command == "TAKEBACK") {
+            std::string text;
+
+            if (Point point{}; stream >> text && parsePoint(text, point)
+                               && engine(brain).lastMove() == point) {
+                engine(brain).undo(1);
+
+                std::cout << "OK" << std::endl;
+            } else {
+                std::cout << "ERROR invalid takeback" << std::endl;
+            }
+        } else {
+            std::cout << "UNKNOWN " << command << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,561 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/policy.h"
+#include "../game/recordfile.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trains the policy network of evaluation/policy.h on record files and writes it quantized.
+// The float network minimises the cross-entropy of a softmax over the empty cells against the
+// record's searched best move. Every epoch sees each position under a random one of the
+// 8 board symmetries. One record in 20 is held out.
+
+namespace {
+using Evaluation::POLICY_CHANNELS;
+
+constexpr int CHANNELS = POLICY_CHANNELS;
+
+struct Options
+{
+    std::string data;
+    std::string output = "policy.bin";
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    int epochs = 20;
+    size_t batch = 1024;
+    double rate = 0.002;
+    unsigned long long seed = 1;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " --data <records.bin> [--output <policy.bin>] [--threads <n>] [--epochs <n>]"
+                 " [--batch <n>] [--rate <r>] [--seed <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--data") {
+            options.data = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--epochs") {
+            options.epochs = std::atoi(value.c_str());
+        } else if (arg == "--batch") {
+            options.batch = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return !options.data.empty() && options.threads > 0 && options.epochs >= 0
+           && options.batch > 0 && options.rate > 0;
+}
+
+// The 8 symmetries of the board, bit 2 mirrors, bits 0-1 rotate a quarter turn each.
+Point transform(Point point, const int &symmetry)
+{
+    if (symmetry & 4) {
+        point.x = 14 - point.x;
+    }
+
+    for (int i = 0; i < (symmetry & 3); ++i) {
+        point = {point.y, 14 - point.x};
+    }
+
+    return point;
+}
+
+struct Sample
+{
+    // Stones of the side to move, then of the opponent.
+    std::array<std::vector<Point>, 2> stones;
+    Point best;
+};
+
+// The float network, and its gradients and Adam moments in the same flat layout:
+// first weights [plane][kernel cell][channel], second weights [kernel cell][input][output].
+constexpr size_t FIRST_BIASES = 2 * 9 * CHANNELS;
+constexpr size_t SECOND_WEIGHTS = FIRST_BIASES + CHANNELS;
+constexpr size_t SECOND_BIASES = SECOND_WEIGHTS + 9 * CHANNELS * CHANNELS;
+constexpr size_t OUTPUT_WEIGHTS = SECOND_BIASES + CHANNELS;
+constexpr size_t PARAMETER_COUNT = OUTPUT_WEIGHTS + CHANNELS;
+// Keeps the quantized layers inside int16 with a full 3x3 neighbourhood of stones.
+constexpr float WEIGHT_LIMIT = 8;
+
+using Parameters = std::vector<float>;
+// [x + 1][y + 1][channel] with a zero border.
+using Plane = std::vector<float>;
+
+size_t cell(const int &x, const int &y, const int &channel = 0)
+{
+    return (static_cast<size_t>(x + 1) * 17 + y + 1) * CHANNELS + channel;
+}
+
+// Cross-entropy of one sample and whether its most likely move is the best move, with the
+// gradient added to gradient when given.
+double train(const Parameters &network,
+             const Sample &sample,
+             const int &symmetry,
+             Parameters *gradient,
+             bool &hit)
+{
+    std::array<std::vector<Point>, 2> stones;
+    std::array<bool, 225> occupied{};
+    Plane first(17 * 17 * CHANNELS);
+    Plane firstInput(17 * 17 * CHANNELS);
+    Plane second(17 * 17 * CHANNELS);
+    Plane secondInput(17 * 17 * CHANNELS);
+    std::array<double, 225> logits{};
+
+    for (size_t plane = 0; plane < 2; ++plane) {
+        for (const auto &point : sample.stones[plane]) {
+            stones[plane].push_back(transform(point, symmetry));
+            occupied[stones[plane].back().x * 15 + stones[plane].back().y] = true;
+        }
+    }
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            std::copy_n(&network[FIRST_BIASES], CHANNELS, &firstInput[cell(x, y)]);
+        }
+    }
+
+    for (size_t plane = 0; plane < 2; ++plane) {
+        for (const auto &[x, y] : stones[plane]) {
+            for (int k = 0; k < 9; ++k) {
+                const auto targetX = x - (k / 3 - 1);
+                const auto targetY = y - (k % 3 - 1);
+
+                if (targetX < 0 || targetX >= 15 || targetY < 0 || targetY >= 15) {
+                    continue;
+                }
+
+                for (int c = 0; c < CHANNELS; ++c) {
+                    firstInput[cell(targetX, targetY, c)] += network[(plane * 9 + k) * CHANNELS
+                                                                     + c];
+                }
+            }
+        }
+    }
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            for (int c = 0; c < CHANNELS; ++c) {
+                first[cell(x, y, c)] = std::clamp(firstInput[cell(x, y, c)], 0.0F, 1.0F);
+            }
+        }
+    }
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            auto *sums = &secondInput[cell(x, y)];
+
+            std::copy_n(&network[SECOND_BIASES], CHANNELS, sums);
+
+            for (int k = 0; k < 9; ++k) {
+                const auto *values = &first[cell(x + k / 3 - 1, y + k % 3 - 1)];
+
+                for (int i = 0; i < CHANNELS; ++i) {
+                    const auto *weights = &network[SECOND_WEIGHTS + (k * CHANNELS + i) * CHANNELS];
+
+                    for (int o = 0; o < CHANNELS; ++o) {
+                        sums[o] += values[i] * weights[o];
+                    }
+                }
+            }
+
+            for (int c = 0; c < CHANNELS; ++c) {
+                second[cell(x, y, c)] = std::clamp(sums[c], 0.0F, 1.0F);
+                logits[x * 15 + y] += second[cell(x, y, c)] * network[OUTPUT_WEIGHTS + c];
+            }
+        }
+    }
+
+    // Softmax over the empty cells.
+    double maxLogit = -1e30;
+
+    for (int i = 0; i < 225; ++i) {
+        if (!occupied[i]) {
+            maxLogit = std::max(maxLogit, logits[i]);
+        }
+    }
+
+    std::array<double, 225> probabilities{};
+    double total = 0;
+
+    for (int i = 0; i < 225; ++i) {
+        if (!occupied[i]) {
+            probabilities[i] = std::exp(logits[i] - maxLogit);
+            total += probabilities[i];
+        }
+    }
+
+    for (auto &probability : probabilities) {
+        probability /= total;
+    }
+
+    const auto best = transform(sample.best, symmetry);
+    const auto target = best.x * 15 + best.y;
+
+    hit = logits[target] >= maxLogit;
+
+    if (gradient) {
+        auto &g = *gradient;
+        Plane firstDelta(17 * 17 * CHANNELS);
+
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                const auto logitDelta = static_cast<float>(probabilities[x * 15 + y]
+                                                           - (x * 15 + y == target));
+                std::array<float, CHANNELS> delta;
+
+                for (int c = 0; c < CHANNELS; ++c) {
+                    const auto input = secondInput[cell(x, y, c)];
+
+                    g[OUTPUT_WEIGHTS + c] += logitDelta * second[cell(x, y, c)];
+                    delta[c] = input > 0 && input < 1 ? logitDelta * network[OUTPUT_WEIGHTS + c]
+                                                      : 0;
+                    g[SECOND_BIASES + c] += delta[c];
+                }
+
+                for (int k = 0; k < 9; ++k) {
+                    const auto index = cell(x + k / 3 - 1, y + k % 3 - 1);
+
+                    for (int i = 0; i < CHANNELS; ++i) {
+                        const auto offset = SECOND_WEIGHTS + (k * CHANNELS + i) * CHANNELS;
+                        float sum = 0;
+
+                        for (int o = 0; o < CHANNELS; ++o) {
+                            g[offset + o] += first[index + i] * delta[o];
+                            sum += network[offset + o] * delta[o];
+                        }
+
+                        firstDelta[index + i] += sum;
+                    }
+                }
+            }
+        }
+
+        // The border cells are padding, their deltas go nowhere.
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                for (int c = 0; c < CHANNELS; ++c) {
+                    const auto input = firstInput[cell(x, y, c)];
+
+                    if (!(input > 0 && input < 1)) {
+                        firstDelta[cell(x, y, c)] = 0;
+                    }
+
+                    g[FIRST_BIASES + c] += firstDelta[cell(x, y, c)];
+                }
+            }
+        }
+
+        for (size_t plane = 0; plane < 2; ++plane) {
+            for (const auto &[x, y] : stones[plane]) {
+                for (int k = 0; k < 9; ++k) {
+                    const auto targetX = x - (k / 3 - 1);
+                    const auto targetY = y - (k % 3 - 1);
+
+                    if (targetX < 0 || targetX >= 15 || targetY < 0 || targetY >= 15) {
+                        continue;
+                    }
+
+                    for (int c = 0; c < CHANNELS; ++c) {
+                        g[(plane * 9 + k) * CHANNELS + c] += firstDelta[cell(targetX, targetY, c)];
+                    }
+                }
+            }
+        }
+    }
+
+    return -std::log(std::max(probabilities[target], 1e-30));
+}
+
+std::unique_ptr<Evaluation::PolicyNetwork> quantize(const Parameters &parameters)
+{
+    auto network = std::make_unique<Evaluation::PolicyNetwork>();
+
+    const auto toInt16 = [](const double &value) {
+        return static_cast<std::int16_t>(std::clamp(std::lround(value), -32767L, 32767L));
+    };
+
+    for (int plane = 0; plane < 2; ++plane) {
+        for (int k = 0; k < 9; ++k) {
+            for (int c = 0; c < CHANNELS; ++c) {
+                network->firstWeights[plane][k][c] = toInt16(
+                    parameters[(plane * 9 + k) * CHANNELS + c] * Evaluation::POLICY_QA);
+            }
+        }
+    }
+
+    for (int c = 0; c < CHANNELS; ++c) {
+        network->firstBiases[c] = toInt16(parameters[FIRST_BIASES + c] * Evaluation::POLICY_QA);
+        network->secondBiases[c] = static_cast<std::int32_t>(
+            std::lround(parameters[SECOND_BIASES + c] * Evaluation::POLICY_QA
+                        * Evaluation::POLICY_QW));
+        network->outputWeights[c] = toInt16(parameters[OUTPUT_WEIGHTS + c]
+                                            * Evaluation::POLICY_LOGIT_SCALE);
+    }
+
+    for (int k = 0; k < 9; ++k) {
+        for (int i = 0; i < CHANNELS; ++i) {
+            for (int o = 0; o < CHANNELS; ++o) {
+                network->secondWeights[k][i / 2][o][i % 2] = toInt16(
+                    parameters[SECOND_WEIGHTS + (k * CHANNELS + i) * CHANNELS + o]
+                    * Evaluation::POLICY_QW);
+            }
+        }
+    }
+
+    return network;
+}
+
+// Top-1 accuracy of the quantized network, as the engine sees it.
+double quantizedAccuracy(const Evaluation::PolicyNetwork &network,
+                         const std::vector<Sample> &samples)
+{
+    std::vector<Evaluation::PolicyInput> inputs;
+    std::vector<Evaluation::PolicyLogits> outputs;
+    size_t hits = 0;
+
+    for (const auto &sample : samples) {
+        Evaluation::PolicyInput input{{}, Black};
+
+        for (auto &column : input.board) {
+            column.fill(Empty);
+        }
+
+        for (size_t plane = 0; plane < 2; ++plane) {
+            for (const auto &[x, y] : sample.stones[plane]) {
+                input.board[x][y] = plane == 0 ? Black : White;
+            }
+        }
+
+        inputs.push_back(input);
+    }
+
+    Evaluation::evaluatePolicy(network, inputs, outputs);
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        int best = -1;
+
+        for (int j = 0; j < 225; ++j) {
+            if (inputs[i].board[j / 15][j % 15] == Empty
+                && (best < 0 || outputs[i][j] > outputs[i][best])) {
+                best = j;
+            }
+        }
+
+        hits += best == samples[i].best.x * 15 + samples[i].best.y;
+    }
+
+    return samples.empty() ? 0 : static_cast<double>(hits) / samples.size();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Game::RecordReader reader;
+
+    if (!reader.open(options.data)) {
+        std::cerr << "Cannot open " << options.data << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Sample> training;
+    std::vector<Sample> validation;
+
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const auto &record = reader[i];
+        const auto best = record.best();
+
+        if (best.x < 0 || record.stone(best) != Empty) {
+            continue;
+        }
+
+        Sample sample;
+
+        for (int x = 0; x < 15; ++x) {
+            for (int y = 0; y < 15; ++y) {
+                if (const auto stone = record.stone({x, y}); stone != Empty) {
+                    sample.stones[stone == record.side() ? 0 : 1].push_back({x, y});
+                }
+            }
+        }
+
+        sample.best = best;
+
+        (i % 20 == 19 ? validation : training).push_back(std::move(sample));
+    }
+
+    if (training.empty()) {
+        std::cerr << "No record with a best move\n";
+
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937_64 random(options.seed);
+    std::normal_distribution<float> initial(0.0F, 1.0F);
+    Parameters network(PARAMETER_COUNT);
+    Parameters mean(PARAMETER_COUNT);
+    Parameters variance(PARAMETER_COUNT);
+    Parameters gradient(PARAMETER_COUNT);
+    std::vector<Parameters> gradients(options.threads, Parameters(PARAMETER_COUNT));
+    Algorithm::WorkStealingPool pool(options.threads);
+
+    // Weights scaled by fan-in, biases start with the units half open.
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+        if (i < FIRST_BIASES) {
+            network[i] = initial(random) / 3;
+        } else if (i < SECOND_WEIGHTS || (i >= SECOND_BIASES && i < OUTPUT_WEIGHTS)) {
+            network[i] = 0.5F;
+        } else if (i < SECOND_BIASES) {
+            network[i] = initial(random) / std::sqrt(9.0F * CHANNELS);
+        } else {
+            network[i] = initial(random) / std::sqrt(static_cast<float>(CHANNELS));
+        }
+    }
+
+    const auto validate = [&] {
+        double loss = 0;
+        size_t hits = 0;
+
+        for (const auto &sample : validation) {
+            bool hit = false;
+
+            loss += train(network, sample, 0, nullptr, hit);
+            hits += hit;
+        }
+
+        return validation.empty()
+                   ? std::pair<double, double>{0, 0}
+                   : std::pair<double, double>{loss / validation.size(),
+                                               static_cast<double>(hits) / validation.size()};
+    };
+
+    const auto [initialLoss, initialAccuracy] = validate();
+
+    std::cerr << training.size() << " training and " << validation.size()
+              << " validation positions, validation loss " << initialLoss << ", top-1 "
+              << initialAccuracy << '\n';
+
+    std::vector<size_t> order(training.size());
+    std::vector<int> symmetries(training.size());
+    unsigned long long step = 0;
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        double loss = 0;
+
+        std::shuffle(order.begin(), order.end(), random);
+
+        for (auto &symmetry : symmetries) {
+            symmetry = static_cast<int>(random() % 8);
+        }
+
+        for (size_t begin = 0; begin < order.size(); begin += options.batch) {
+            const auto end = std::min(order.size(), begin + options.batch);
+            const auto chunk = (end - begin + options.threads - 1) / options.threads;
+            std::vector<double> losses(options.threads);
+
+            for (size_t t = 0; t < options.threads; ++t) {
+                pool.submit([&, t](const size_t &) {
+                    const auto last = std::min(end, begin + (t + 1) * chunk);
+                    bool hit = false;
+
+                    std::fill(gradients[t].begin(), gradients[t].end(), 0.0F);
+
+                    for (auto i = begin + t * chunk; i < last; ++i) {
+                        losses[t] += train(network,
+                                           training[order[i]],
+                                           symmetries[order[i]],
+                                           &gradients[t],
+                                           hit);
+                    }
+                });
+            }
+
+            pool.wait();
+            std::fill(gradient.begin(), gradient.end(), 0.0F);
+
+            for (size_t t = 0; t < options.threads; ++t) {
+                loss += losses[t];
+
+                for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+                    gradient[i] += gradients[t][i];
+                }
+            }
+
+            // Adam on the batch mean gradient.
+            ++step;
+
+            const auto size = static_cast<float>(end - begin);
+            const auto meanCorrection = static_cast<float>(1 - std::pow(0.9, step));
+            const auto varianceCorrection = static_cast<float>(1 - std::pow(0.999, step));
+
+            for (size_t i = 0; i < PARAMETER_COUNT; ++i) {
+                const auto g = gradient[i] / size;
+
+                mean[i] = 0.9F * mean[i] + 0.1F * g;
+                variance[i] = 0.999F * variance[i] + 0.001F * g * g;
+                network[i] -= static_cast<float>(options.rate) * (mean[i] / meanCorrection)
+                              / (std::sqrt(variance[i] / varianceCorrection) + 1e-8F);
+                network[i] = std::clamp(network[i], -WEIGHT_LIMIT, WEIGHT_LIMIT);
+            }
+        }
+
+        const auto [validationLoss, accuracy] = validate();
+
+        std::cerr << "epoch " << epoch << ", training loss " << loss / training.size()
+                  << ", validation loss " << validationLoss << ", top-1 " << accuracy << '\n';
+    }
+
+    const auto quantized = quantize(network);
+
+    std::cerr << "quantized top-1 " << quantizedAccuracy(*quantized, validation) << '\n';
+
+    if (!Evaluation::savePolicy(options.output, *quantized)) {
+        std::cerr << "Cannot write " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "../game/position.h"
+#include "../game/recordfile.h"
+#include "../search/engine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Converts text positions to the binary record format and back, and checks record files.
+//   pack <positions.txt> <records.bin>  appends the positions to a record file
+//   unpack <records.bin>                 prints the records as text positions
+//   scan <records.bin>                   maps the file and times a pass over all records
+//   verify <records.bin>                 round-trips every record through an Engine
+
+namespace {
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " pack <positions.txt> <records.bin> | unpack <records.bin>"
+                 " | scan <records.bin> | verify <records.bin>\n";
+}
+
+int pack(const std::string &input, const std::string &output)
+{
+    const auto positions = Game::loadPositions(input);
+    Game::RecordWriter writer;
+
+    if (!positions) {
+        std::cerr << "Cannot load " << input << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if (!writer.open(output, true)) {
+        std::cerr << "Cannot open " << output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    for (const auto &position : *positions) {
+        writer.write(Game::toRecord(position));
+    }
+
+    if (!writer.close()) {
+        std::cerr << "Cannot write " << output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << positions->size() << " records written\n";
+
+    return EXIT_SUCCESS;
+}
+
+int unpack(const Game::RecordReader &reader)
+{
+    size_t index = 0;
+
+    for (const auto &record : reader) {
+        std::cout << "record-" << index++ << " record";
+
+        if (const auto moves = Game::toMoves(record)) {
+            for (const auto &move : *moves) {
+                std::cout << ' ' << Game::toString(move);
+            }
+        } else {
+            std::cout << " # unreachable position";
+        }
+
+        std::cout << '\n';
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int scan(const std::string &path)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Game::RecordReader reader;
+
+    if (!reader.open(path)) {
+        std::cerr << "Cannot open " << path << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    const auto opened = std::chrono::steady_clock::now();
+    unsigned long long stones = 0;
+
+    for (const auto &record : reader) {
+        stones += record.stoneCount();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    std::cout << "{\"records\":" << reader.size() << ",\"stones\":" << stones
+              << ",\"open_ms\":" << std::chrono::duration<double, std::milli>(opened - start).count()
+              << ",\"scan_ms\":" << std::chrono::duration<double, std::milli>(end - opened).count()
+              << "}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+int verify(const Game::RecordReader &reader)
+{
+    Search::Engine engine(1 << 20);
+    size_t failures = 0;
+
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const auto &record = reader[i];
+        const auto moves = Game::toMoves(record);
+
+        if (!moves || !Game::setup(engine, record)) {
+            std::cerr << "record " << i << ": unreachable position\n";
+            ++failures;
+
+            continue;
+        }
+
+        auto copy = Game::toRecord(engine, record.side());
+
+        copy.result = record.result;
+        copy.score = record.score;
+        copy.bestMove = record.bestMove;
+        copy.reserved = record.reserved;
+
+        if (std::memcmp(&copy, &record, sizeof(Game::Record)) != 0) {
+            std::cerr << "record " << i << ": round trip mismatch\n";
+            ++failures;
+        }
+
+        engine.undo(static_cast<int>(moves->size()));
+    }
+
+    std::cerr << reader.size() << " records checked, " << failures << " failures\n";
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::string command = argc > 1 ? argv[1] : "";
+
+    if (command == "pack" && argc == 4) {
+        return pack(argv[2], argv[3]);
+    }
+
+    if (command == "scan" && argc == 3) {
+        return scan(argv[2]);
+    }
+
+    if ((command == "unpack" || command == "verify") && argc == 3) {
+        Game::RecordReader reader;
+
+        if (!reader.open(argv[2])) {
+            std::cerr << "Cannot open " << argv[2] << '\n';
+
+            return EXIT_FAILURE;
+        }
+
+        return command == "unpack" ? unpack(reader) : verify(reader);
+    }
+
+    printUsage(argv[0]);
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,755 @@
+#include "../evaluation/evaluator.h"
+#include "../game/position.h"
+#include "../search/engine.h"
+#include "../search/solvedstore.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Serves analysis requests over a Unix domain socket from a pool of warm engines, one per
+// worker thread, which keep their transposition tables between requests.
+// Every line sent is a flat JSON object, answered by one JSON line, in completion order:
+//   {"id":"a","moves":"7,7 7,8","depth":10,"time_ms":500,"nodes":0,"deadline_ms":800}
+//   {"id":"a","best_move":"8,8","score":35,...,"queue_us":12,"time_us":498000}
+//   {"command":"stats"}
+//   {"queue":0,"busy":1,...,"latency_ms":{"samples":1,"p50":498.0,"p90":498.0,"p99":498.0}}
+// Requests wait in earliest deadline first order, those without a deadline last in arrival
+// order. deadline_ms counts from the arrival: a request still queued at its deadline is answered
+// with an error at once, otherwise its search gets at most the time left. Omitted limits default
+// to the command line ones, a search left without deadline, time and nodes stops after a
+// minute. The --memory budget holds the tables and the evaluation caches of every worker, the
+// caches taking a quarter of a worker's share. hash_mb resizes the worker's tables before the
+// search, within what the caches and the other tables leave.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Kept from a deadline for the reply, searches stop a little after their time.
+constexpr auto DEADLINE_MARGIN = std::chrono::milliseconds(20);
+// So that a request without limits cannot hold its worker for good.
+constexpr auto MAX_SEARCH_TIME = std::chrono::minutes(1);
+constexpr size_t LATENCY_SAMPLES = 4096;
+constexpr size_t MAX_LINE = 1 << 16;
+constexpr char ESCAPES[] = "\"\\/bfnrt";
+constexpr char UNESCAPED[] = "\"\\/\b\f\n\r\t";
+
+sockaddr_un address{};
+
+struct Options
+{
+    std::string socket = "/tmp/gomoku.sock";
+    size_t engines = std::max(1U, std::thread::hardware_concurrency());
+    // MB for the tables and the evaluation caches of all the engines.
+    size_t memory = 1024;
+    Search::Limits limits;
+    std::shared_ptr<Search::SolvedStore> solved;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--socket <path>] [--engines <n>] [--memory <MB>] [--depth <n>] [--time <ms>]"
+                 " [--nodes <n>] [--solved <file>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--socket") {
+            options.socket = value;
+        } else if (arg == "--engines") {
+            options.engines = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--memory") {
+            options.memory = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--depth") {
+            options.limits.depth = std::atoi(value.c_str());
+        } else if (arg == "--time") {
+            options.limits.time = std::chrono::milliseconds(std::atoll(value.c_str()));
+        } else if (arg == "--nodes") {
+            options.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--solved") {
+            options.solved = Search::SolvedStore::open(value);
+
+            if (!options.solved) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return options.engines > 0 && options.memory >= options.engines
+           && options.limits.depth > 0 && options.limits.depth <= 225
+           && options.socket.size() < sizeof(address.sun_path);
+}
+
+// The members of a flat JSON object, strings unescaped and other values as written.
+using Request = std::map<std::string, std::string>;
+
+void skipSpaces(const std::string &text, size_t &i)
+{
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+        ++i;
+    }
+}
+
+bool parseString(const std::string &text, size_t &i, std::string &string)
+{
+    if (i >= text.size() || text[i] != '"') {
+        return false;
+    }
+
+    for (++i; i < text.size() && text[i] != '"'; ++i) {
+        if (text[i] != '\\') {
+            string += text[i];
+
+            continue;
+        }
+
+        const auto *escape = ++i < text.size() ? std::strchr(ESCAPES, text[i]) : nullptr;
+
+        // \u escapes are not needed by the requests.
+        if (!escape || !*escape) {
+            return false;
+        }
+
+        string += UNESCAPED[escape - ESCAPES];
+    }
+
+    return i++ < text.size();
+}
+
+std::optional<Request> parseRequest(const std::string &text)
+{
+    Request request;
+    size_t i = 0;
+
+    skipSpaces(text, i);
+
+    if (i >= text.size() || text[i++] != '{') {
+        return std::nullopt;
+    }
+
+    skipSpaces(text, i);
+
+    while (i < text.size() && text[i] != '}') {
+        std::string key;
+        std::string value;
+
+        if (!parseString(text, i, key)) {
+            return std::nullopt;
+        }
+
+        skipSpaces(text, i);
+
+        if (i >= text.size() || text[i++] != ':') {
+            return std::nullopt;
+        }
+
+        skipSpaces(text, i);
+
+        if (i < text.size() && text[i] == '"') {
+            if (!parseString(text, i, value)) {
+                return std::nullopt;
+            }
+        } else {
+            while (i < text.size() && !std::strchr(",} \t\r\n", text[i])) {
+                value += text[i++];
+            }
+
+            if (value.empty()) {
+                return std::nullopt;
+            }
+        }
+
+        request[key] = value;
+        skipSpaces(text, i);
+
+        if (i < text.size() && text[i] == ',') {
+            skipSpaces(text, ++i);
+
+            if (i >= text.size() || text[i] != '"') {
+                return std::nullopt;
+            }
+        } else if (i >= text.size() || text[i] != '}') {
+            return std::nullopt;
+        }
+    }
+
+    if (i++ >= text.size()) {
+        return std::nullopt;
+    }
+
+    skipSpaces(text, i);
+
+    return i == text.size() ? std::optional(request) : std::nullopt;
+}
+
+// The member as a number, the fallback when it is missing, nullopt when it is not a number.
+std::optional<long long> number(const Request &request,
+                                const std::string &key,
+                                const long long &fallback)
+{
+    const auto member = request.find(key);
+
+    if (member == request.end()) {
+        return fallback;
+    }
+
+    char *end = nullptr;
+    const auto value = std::strtoll(member->second.c_str(), &end, 10);
+
+    if (member->second.empty() || *end || value < 0) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+std::string quote(const std::string &text)
+{
+    std::ostringstream stream;
+
+    stream << '"';
+
+    for (const auto &c : text) {
+        if (c == '"' || c == '\\') {
+            stream << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                   << std::dec;
+        } else {
+            stream << c;
+        }
+    }
+
+    stream << '"';
+
+    return stream.str();
+}
+
+std::string errorJson(const std::string &id, const std::string &error)
+{
+    return "{\"id\":" + quote(id) + ",\"error\":" + quote(error) + "}";
+}
+
+// A client socket, closed when the last queued request of the client is answered.
+class Connection
+{
+private:
+    int fd;
+    std::mutex mutex;
+
+public:
+    explicit Connection(const int &fd)
+        : fd(fd)
+    {}
+
+    Connection(const Connection &) = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    ~Connection() { ::close(fd); }
+
+    [[nodiscard]] int descriptor() const { return fd; }
+
+    // Replies of several workers go out whole, one line each. Errors are dropped, the reader
+    // sees the connection end.
+    void send(const std::string &json)
+    {
+        const auto line = json + '\n';
+        std::lock_guard lock(mutex);
+
+        for (size_t sent = 0; sent < line.size();) {
+            const auto count = ::write(fd, line.data() + sent, line.size() - sent);
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count <= 0) {
+                return;
+            }
+
+            sent += count;
+        }
+    }
+};
+
+struct Job
+{
+    unsigned long long sequence = 0;
+    Clock::time_point received;
+    std::optional<Clock::time_point> deadline;
+    std::string id;
+    Game::Position position;
+    Search::Limits limits;
+    // Bytes of transposition tables asked for, 0 keeps the worker's.
+    size_t hashSize = 0;
+    std::shared_ptr<Connection> connection;
+};
+
+// Orders the queue with the earliest deadline on top.
+struct Later
+{
+    bool operator()(const Job &a, const Job &b) const
+    {
+        if (a.deadline.has_value() != b.deadline.has_value()) {
+            return !a.deadline;
+        }
+
+        if (a.deadline && *a.deadline != *b.deadline) {
+            return *a.deadline > *b.deadline;
+        }
+
+        return a.sequence > b.sequence;
+    }
+};
+
+class Server
+{
+private:
+    std::vector<std::unique_ptr<Search::Engine>> engines;
+    std::vector<size_t> hashSizes;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable deadlineQueued;
+    std::priority_queue<Job, std::vector<Job>, Later> queue;
+    const size_t memory;
+    // Bytes of evaluation caches of every worker thread.
+    const size_t cacheSize;
+    // Bytes asked for by all the engines' tables, never over memory less the caches.
+    size_t allocated;
+    size_t busy;
+    unsigned long long sequence;
+    unsigned long long completed;
+    unsigned long long expired;
+    unsigned long long rejected;
+    // Milliseconds from arrival to reply of the last requests, a ring buffer.
+    std::vector<double> latencies;
+    size_t nextLatency;
+
+    void run(const size_t &worker)
+    {
+        auto &engine = *engines[worker];
+
+        Evaluation::Evaluator::setCacheSize(cacheSize);
+
+        while (true) {
+            std::unique_lock lock(mutex);
+
+            jobAvailable.wait(lock, [this] { return !queue.empty(); });
+
+            auto job = queue.top();
+
+            queue.pop();
+            ++busy;
+
+            // The worker's own share is free to take back, the others' tables stay as they are.
+            const auto hashSize
+                = std::min(job.hashSize, tableMemory() - (allocated - hashSizes[worker]));
+
+            if (job.hashSize && hashSize != hashSizes[worker]) {
+                allocated += hashSize - hashSizes[worker];
+                hashSizes[worker] = hashSize;
+                lock.unlock();
+                engine.setHashSize(hashSize);
+            } else {
+                lock.unlock();
+            }
+
+            const auto start = Clock::now();
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                job.deadline.value_or(start) - start - DEADLINE_MARGIN);
+            const auto late = job.deadline && left.count() <= 0;
+            auto result = errorJson(job.id, "deadline expired");
+
+            if (!late) {
+                if (job.deadline) {
+                    job.limits.time = job.limits.time.count() ? std::min(job.limits.time, left)
+                                                              : left;
+                }
+
+                Game::setup(engine, job.position);
+
+                const auto stats
+                    = engine.search(Game::sideToMove(job.position), job.limits);
+
+                engine.undo(static_cast<int>(job.position.moves.size()));
+                result = resultJson(job, stats, start);
+            }
+
+            lock.lock();
+            --busy;
+            answer(lock, job, result, late);
+        }
+    }
+
+    // Answers the queued requests as their deadlines pass, busy workers or not.
+    void expire()
+    {
+        std::unique_lock lock(mutex);
+
+        while (true) {
+            // Requests with a deadline are on top, the earliest first.
+            if (queue.empty() || !queue.top().deadline) {
+                deadlineQueued.wait(lock);
+
+                continue;
+            }
+
+            const auto due = *queue.top().deadline - DEADLINE_MARGIN;
+
+            if (Clock::now() < due) {
+                deadlineQueued.wait_until(lock, due);
+
+                continue;
+            }
+
+            const auto job = queue.top();
+
+            queue.pop();
+            answer(lock, job, errorJson(job.id, "deadline expired"), true);
+            lock.lock();
+        }
+    }
+
+    // Counts the reply with the lock held, then releases it and sends the reply.
+    void answer(std::unique_lock<std::mutex> &lock,
+                const Job &job,
+                const std::string &result,
+                const bool &late)
+    {
+        ++completed;
+        expired += late;
+
+        const auto latency
+            = std::chrono::duration<double, std::milli>(Clock::now() - job.received);
+
+        if (latencies.size() < LATENCY_SAMPLES) {
+            latencies.push_back(latency.count());
+        } else {
+            latencies[nextLatency] = latency.count();
+        }
+
+        nextLatency = (nextLatency + 1) % LATENCY_SAMPLES;
+        lock.unlock();
+        // After the counters, so that a client sees its requests in the statistics.
+        job.connection->send(result);
+    }
+
+    // The budget left to the tables once the caches of every worker are counted.
+    [[nodiscard]] size_t tableMemory() const { return memory - engines.size() * cacheSize; }
+
+    static std::string resultJson(const Job &job,
+                                  const Search::SearchStats &stats,
+                                  const Clock::time_point &start)
+    {
+        std::ostringstream stream;
+
+        stream << "{\"id\":" << quote(job.id) << ",\"best_move\":\""
+               << Game::toString(stats.bestMove) << "\",\"score\":" << stats.score
+               << ",\"depth\":" << stats.depth << ",\"seldepth\":" << stats.seldepth
+               << ",\"pv\":[";
+
+        for (size_t i = 0; i < stats.pv.size(); ++i) {
+            stream << (i ? ",\"" : "\"") << Game::toString(stats.pv[i]) << '"';
+        }
+
+        stream << "],\"nodes\":" << stats.nodes << ",\"queue_us\":"
+               << std::chrono::duration_cast<std::chrono::microseconds>(start - job.received)
+                      .count()
+               << ",\"time_us\":" << stats.time.count()
+               << ",\"book\":" << (stats.bookMove ? "true" : "false")
+               << ",\"solved\":" << (stats.solved ? "true" : "false") << "}";
+
+        return stream.str();
+    }
+
+public:
+    explicit Server(const Options &options)
+        : memory(options.memory << 20)
+        , cacheSize(memory / options.engines / 4)
+        , allocated(0)
+        , busy(0)
+        , sequence(0)
+        , completed(0)
+        , expired(0)
+        , rejected(0)
+        , nextLatency(0)
+    {
+        for (size_t i = 0; i < options.engines; ++i) {
+            hashSizes.push_back(memory / options.engines - cacheSize);
+            allocated += hashSizes.back();
+            engines.push_back(std::make_unique<Search::Engine>(hashSizes.back()));
+            engines.back()->setSolvedStore(options.solved);
+        }
+
+        // The workers run until the process ends.
+        for (size_t i = 0; i < options.engines; ++i) {
+            std::thread([this, i] { run(i); }).detach();
+        }
+
+        std::thread([this] { expire(); }).detach();
+    }
+
+    void submit(Job job)
+    {
+        const auto deadline = job.deadline.has_value();
+
+        {
+            std::lock_guard lock(mutex);
+
+            job.sequence = sequence++;
+            queue.push(std::move(job));
+        }
+
+        jobAvailable.notify_one();
+
+        if (deadline) {
+            deadlineQueued.notify_one();
+        }
+    }
+
+    void reject()
+    {
+        std::lock_guard lock(mutex);
+
+        ++rejected;
+    }
+
+    // Queue depth, pool use, the memory budget and the nearest rank latency percentiles.
+    std::string statistics()
+    {
+        std::unique_lock lock(mutex);
+        auto samples = latencies;
+        std::ostringstream stream;
+
+        stream << "{\"queue\":" << queue.size() << ",\"busy\":" << busy
+               << ",\"engines\":" << engines.size() << ",\"completed\":" << completed
+               << ",\"expired\":" << expired << ",\"rejected\":" << rejected
+               << ",\"memory_mb\":" << ((allocated + engines.size() * cacheSize) >> 20)
+               << ",\"cache_mb\":" << ((engines.size() * cacheSize) >> 20)
+               << ",\"memory_budget_mb\":" << (memory >> 20);
+        lock.unlock();
+        std::sort(samples.begin(), samples.end());
+        stream << ",\"latency_ms\":{\"samples\":" << samples.size() << std::fixed
+               << std::setprecision(3);
+
+        for (const auto &[name, percentile] :
+             {std::pair{"p50", 50}, std::pair{"p90", 90}, std::pair{"p99", 99}}) {
+            const auto rank = (samples.size() * percentile + 99) / 100;
+
+            stream << ",\"" << name << "\":" << (rank ? samples[rank - 1] : 0.0);
+        }
+
+        stream << ",\"max\":" << (samples.empty() ? 0.0 : samples.back()) << "}}";
+
+        return stream.str();
+    }
+};
+
+void handle(Server &server,
+            const Options &options,
+            const std::shared_ptr<Connection> &connection,
+            const std::string &line)
+{
+    const auto request = parseRequest(line);
+
+    if (!request) {
+        server.reject();
+        connection->send(errorJson("", "invalid JSON object"));
+
+        return;
+    }
+
+    const auto get = [&](const std::string &key) {
+        const auto member = request->find(key);
+
+        return member == request->end() ? std::string() : member->second;
+    };
+    const auto command = get("command");
+    Job job;
+
+    job.received = Clock::now();
+    job.id = get("id");
+    job.connection = connection;
+
+    if (command == "stats") {
+        connection->send(server.statistics());
+
+        return;
+    }
+
+    if (!command.empty() && command != "analyze") {
+        server.reject();
+        connection->send(errorJson(job.id, "unknown command " + command));
+
+        return;
+    }
+
+    const auto depth = number(*request, "depth", options.limits.depth);
+    const auto time = number(*request, "time_ms", options.limits.time.count());
+    const auto nodes = number(*request, "nodes", options.limits.nodes);
+    const auto deadline = number(*request, "deadline_ms", 0);
+    const auto hash = number(*request, "hash_mb", 0);
+    auto position = Game::parsePosition("request analyze " + get("moves"));
+
+    if (!depth || !time || !nodes || !deadline || !hash || *depth < 1 || *depth > 225) {
+        server.reject();
+        connection->send(errorJson(job.id, "invalid limits"));
+
+        return;
+    }
+
+    if (!position) {
+        server.reject();
+        connection->send(errorJson(job.id, "invalid moves"));
+
+        return;
+    }
+
+    job.position = std::move(*position);
+    job.limits.depth = static_cast<int>(*depth);
+    job.limits.time = std::chrono::milliseconds(*time);
+    job.limits.nodes = *nodes;
+    job.hashSize = static_cast<size_t>(*hash) << 20;
+
+    if (*deadline) {
+        job.deadline = job.received + std::chrono::milliseconds(*deadline);
+    } else if (!job.limits.time.count() && !job.limits.nodes) {
+        job.limits.time = MAX_SEARCH_TIME;
+    }
+
+    server.submit(std::move(job));
+}
+
+// Reads request lines until the client closes, the replies may outlive it.
+void serve(Server &server, const Options &options, std::shared_ptr<Connection> connection)
+{
+    std::string buffer;
+    char chunk[4096];
+
+    while (true) {
+        const auto count = ::read(connection->descriptor(), chunk, sizeof(chunk));
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            return;
+        }
+
+        buffer.append(chunk, count);
+
+        for (auto end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n')) {
+            const auto line = buffer.substr(0, end);
+
+            buffer.erase(0, end + 1);
+
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                handle(server, options, connection, line);
+            }
+        }
+
+        if (buffer.size() > MAX_LINE) {
+            connection->send(errorJson("", "request too long"));
+
+            return;
+        }
+    }
+}
+
+extern "C" void stop(int)
+{
+    ::unlink(address.sun_path);
+    ::_exit(EXIT_SUCCESS);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, options.socket.c_str());
+    // A socket file left by a server that was killed.
+    ::unlink(address.sun_path);
+
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address))
+        || ::listen(listener, 64)) {
+        std::cerr << "Cannot listen on " << options.socket << ": " << std::strerror(errno)
+                  << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    // Replies to closed clients fail instead of killing the server.
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    Server server(options);
+
+    std::cerr << "Listening on " << options.socket << " with " << options.engines
+              << " engines and " << options.memory << " MB of tables\n";
+
+    while (true) {
+        const auto client = ::accept(listener, nullptr, nullptr);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            std::cerr << "Cannot accept: " << std::strerror(errno) << '\n';
+            // The detached threads still use the server and the options, returning would
+            // destroy them under the threads.
+            ::unlink(address.sun_path);
+            ::_exit(EXIT_FAILURE);
+        }
+
+        std::thread(serve,
+                    std::ref(server),
+                    std::cref(options),
+                    std::make_shared<Connection>(client))
+            .detach();
+    }
+}
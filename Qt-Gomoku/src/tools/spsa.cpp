@@ -0,0 +1,301 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/evaluator.h"
+#include "../game/position.h"
+#include "../match/selfplay.h"
+#include "../match/spsa.h"
+#include "../search/engine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tunes the search parameters by SPSA: every iteration plays --pairs game pairs (same opening,
+// colours swapped) between the two perturbed settings at a fixed time per move, so that a
+// setting that searches deeper but slower has to win on the board. The state is saved to the
+// checkpoint after every iteration and loaded at start, a stopped run resumes where it was.
+
+#ifndef GOMOKU_BENCH_CORPUS
+#define GOMOKU_BENCH_CORPUS "positions.txt"
+#endif
+
+namespace {
+struct Options
+{
+    std::string openings = GOMOKU_BENCH_CORPUS;
+    std::string category = "opening";
+    std::string checkpoint = "spsa.txt";
+    unsigned long long iterations = 1000;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    size_t pairs = 0;
+    size_t hashSize = 16;
+    // MB of evaluation shape caches per worker thread.
+    size_t cacheSize = 64;
+    std::chrono::milliseconds time{20};
+    unsigned long long nodes = 0;
+    double rate = 0.02;
+    unsigned long long seed = 1;
+};
+
+// The tuned settings, in the gomoku-match configuration keys, with their ranges and final
+// perturbations. Integer settings are rounded, their perturbation stays above one half.
+std::vector<Match::Spsa::Parameter> tunedParameters()
+{
+    const Search::Parameters parameters;
+
+    return {{"depth", static_cast<double>(Search::LIMIT_DEPTH), 4, 24, 1},
+            {"mc_c", static_cast<double>(parameters.multiCutC), 1, 8, 0.6},
+            {"mc_m", static_cast<double>(parameters.multiCutM), 2, 24, 1.5},
+            {"mc_r", static_cast<double>(parameters.multiCutR), 1, 6, 0.6},
+            {"null_r", static_cast<double>(parameters.nullMoveR), 1, 5, 0.6},
+            {"null_depth", static_cast<double>(parameters.nullMoveDepth), 2, 12, 1},
+            {"futility", static_cast<double>(parameters.futilityMargin), 0, 600, 30},
+            {"move_exp", parameters.moveCountExponent, 1, 1.8, 0.05}};
+}
+
+struct Configuration
+{
+    Search::Parameters parameters;
+    int depth;
+};
+
+Configuration toConfiguration(const std::vector<double> &values)
+{
+    const auto rounded = [&values](const size_t &i) {
+        return static_cast<int>(std::lround(values[i]));
+    };
+
+    Configuration configuration;
+
+    configuration.depth = rounded(0);
+    configuration.parameters.multiCutC = rounded(1);
+    configuration.parameters.multiCutM = rounded(2);
+    configuration.parameters.multiCutR = rounded(3);
+    configuration.parameters.nullMoveR = rounded(4);
+    configuration.parameters.nullMoveDepth = rounded(5);
+    configuration.parameters.futilityMargin = rounded(6);
+    configuration.parameters.moveCountExponent = values[7];
+
+    return configuration;
+}
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " [--iterations <n>] [--pairs <n>] [--threads <n>] [--time <ms>] [--nodes <n>]"
+                 " [--hash <MB per engine>] [--cache-mb <MB per thread>] [--openings <file>]"
+                 " [--category <name>|all] [--checkpoint <file>] [--rate <r>] [--seed <n>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--iterations") {
+            options.iterations = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--pairs") {
+            options.pairs = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--time") {
+            options.time = std::chrono::milliseconds(std::atoll(value.c_str()));
+        } else if (arg == "--nodes") {
+            options.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--hash") {
+            options.hashSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--cache-mb") {
+            options.cacheSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--openings") {
+            options.openings = value;
+        } else if (arg == "--category") {
+            options.category = value;
+        } else if (arg == "--checkpoint") {
+            options.checkpoint = value;
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    if (!options.pairs) {
+        options.pairs = options.threads;
+    }
+
+    return options.iterations > 0 && options.threads > 0 && options.hashSize > 0
+           && options.cacheSize > 0 && (options.time.count() > 0 || options.nodes > 0)
+           && options.rate > 0;
+}
+
+std::string toString(const std::vector<Match::Spsa::Parameter> &parameters)
+{
+    const auto configuration = toConfiguration([&parameters] {
+        std::vector<double> values;
+
+        for (const auto &parameter : parameters) {
+            values.push_back(parameter.value);
+        }
+
+        return values;
+    }());
+
+    std::ostringstream stream;
+
+    stream << "depth=" << configuration.depth << ",mc_c=" << configuration.parameters.multiCutC
+           << ",mc_m=" << configuration.parameters.multiCutM
+           << ",mc_r=" << configuration.parameters.multiCutR
+           << ",null_r=" << configuration.parameters.nullMoveR
+           << ",null_depth=" << configuration.parameters.nullMoveDepth
+           << ",futility=" << configuration.parameters.futilityMargin << ",move_exp=" << std::fixed
+           << std::setprecision(3) << configuration.parameters.moveCountExponent;
+
+    return stream.str();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    auto positions = Game::loadPositions(options.openings);
+
+    if (!positions) {
+        std::cerr << "Cannot load the openings " << options.openings << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if (options.category != "all") {
+        positions->erase(std::remove_if(positions->begin(),
+                                        positions->end(),
+                                        [&options](const auto &position) {
+                                            return position.category != options.category;
+                                        }),
+                         positions->end());
+    }
+
+    if (positions->empty()) {
+        std::cerr << "No opening positions\n";
+
+        return EXIT_FAILURE;
+    }
+
+    Match::Spsa spsa(tunedParameters(), options.rate, options.iterations);
+
+    if (std::ifstream(options.checkpoint) && !spsa.load(options.checkpoint)) {
+        std::cerr << "Invalid checkpoint " << options.checkpoint << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if (spsa.iteration()) {
+        std::cerr << "Resuming at iteration " << spsa.iteration() << ": " << toString(spsa.values())
+                  << '\n';
+    }
+
+    // Two engines per worker, the plus and minus settings of the current iteration.
+    std::vector<std::array<std::unique_ptr<Search::Engine>, 2>> engines(options.threads);
+
+    for (auto &pair : engines) {
+        for (auto &engine : pair) {
+            engine = std::make_unique<Search::Engine>(options.hashSize << 20);
+        }
+    }
+
+    Algorithm::WorkStealingPool pool(options.threads);
+
+    while (spsa.iteration() < options.iterations) {
+        // Seeded by iteration, a resumed run plays what the uninterrupted one would have.
+        std::mt19937_64 random(options.seed * 0x9e3779b97f4a7c15ULL + spsa.iteration());
+        const auto perturbation = spsa.perturb(random);
+        const std::array<Configuration, 2> configurations = {toConfiguration(perturbation.plus),
+                                                             toConfiguration(perturbation.minus)};
+        std::mutex mutex;
+        double result = 0;
+
+        for (size_t pair = 0; pair < options.pairs; ++pair) {
+            const auto &opening = (*positions)[random() % positions->size()].moves;
+
+            pool.submit([&, opening](const size_t &worker) {
+                double points = 0;
+
+                Evaluation::Evaluator::setCacheSize(options.cacheSize << 20);
+
+                for (size_t i = 0; i < 2; ++i) {
+                    engines[worker][i]->setParameters(configurations[i].parameters);
+                }
+
+                // Plus plays black in the first game and white in the second.
+                for (size_t first = 0; first < 2; ++first) {
+                    Search::Limits limits;
+
+                    limits.time = options.time;
+                    limits.nodes = options.nodes;
+
+                    limits.depth = configurations[first].depth;
+                    const Match::Player black{engines[worker][first].get(), limits};
+
+                    limits.depth = configurations[1 - first].depth;
+                    const Match::Player white{engines[worker][1 - first].get(), limits};
+
+                    const auto outcome = Match::play(black, white, opening);
+
+                    if (outcome != Game::Result::Draw) {
+                        points += (outcome == Game::Result::BlackWin) == !first ? 1 : -1;
+                    }
+                }
+
+                std::lock_guard lock(mutex);
+
+                result += points;
+            });
+        }
+
+        pool.wait();
+        spsa.update(perturbation, result / (2.0 * options.pairs));
+
+        if (!spsa.save(options.checkpoint)) {
+            std::cerr << "Cannot write " << options.checkpoint << '\n';
+
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "{\"iteration\":" << spsa.iteration() << ",\"result\":" << result;
+
+        for (const auto &parameter : spsa.values()) {
+            std::cout << ",\"" << parameter.name << "\":" << parameter.value;
+        }
+
+        std::cout << '}' << std::endl;
+    }
+
+    std::cout << "{\"config\":\"" << toString(spsa.values()) << "\"}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
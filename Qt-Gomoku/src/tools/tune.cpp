@@ -0,0 +1,356 @@
+#include "../algorithm/workstealingpool.hpp"
+#include "../evaluation/evaluator.h"
+#include "../evaluation/weights.h"
+#include "../game/recordfile.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Texel tuning of the shape weights: fits sigmoid(k * evaluation) of every record with a known
+// result to that result (1 win, 0.5 draw, 0 loss of the side to move) by gradient descent, and
+// writes the weights in the format Evaluation::loadWeights reads. The evaluation is linear in
+// the weights, so each record is reduced once to its own minus opponent shape counts.
+
+namespace {
+struct Options
+{
+    std::string data;
+    std::string output = "weights.txt";
+    std::string initial;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    int iterations = 2000;
+    double rate = 2;
+    double k = 0;
+};
+
+struct Sample
+{
+    std::array<float, Evaluation::SHAPES.size()> features;
+    float result;
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " --data <records.bin> [--output <weights.txt>] [--initial <weights.txt>]"
+                 " [--threads <n>] [--iterations <n>] [--rate <r>] [--k <k>]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--data") {
+            options.data = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--initial") {
+            options.initial = value;
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--iterations") {
+            options.iterations = std::atoi(value.c_str());
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (arg == "--k") {
+            options.k = std::atof(value.c_str());
+        } else {
+            return false;
+        }
+    }
+
+    return !options.data.empty() && options.threads > 0 && options.iterations >= 0
+           && options.rate > 0 && options.k >= 0;
+}
+
+// The 72 lines as Engine keeps them: rows, columns, diagonals and anti-diagonals of 5 cells
+// or more, '1' for the stones of the given side and '2' for the other side.
+std::array<std::string, 72> lines(const Game::Record &record, const Stone &stone)
+{
+    std::array<std::string, 72> shapes;
+
+    for (int x = 0; x < 15; ++x) {
+        for (int y = 0; y < 15; ++y) {
+            const auto cell = record.stone({x, y});
+            const char c = cell == Empty ? '0' : cell == stone ? '1' : '2';
+
+            shapes[y] += c;
+            shapes[x + 15] += c;
+
+            if (std::abs(y - x) <= 10) {
+                shapes[y - x + 40] += c;
+            }
+        }
+    }
+
+    // Anti-diagonals are indexed from their top row, fill them in that order.
+    for (int sum = 4; sum <= 24; ++sum) {
+        for (int y = std::max(0, sum - 14); y <= std::min(14, sum); ++y) {
+            const auto cell = record.stone({sum - y, y});
+
+            shapes[sum + 47] += cell == Empty ? '0' : cell == stone ? '1' : '2';
+        }
+    }
+
+    return shapes;
+}
+
+bool toSample(const Game::Record &record, Sample &sample)
+{
+    if (record.result == Game::Result::Unknown) {
+        return false;
+    }
+
+    const auto side = record.side();
+    Evaluation::ShapeCounts own{};
+    Evaluation::ShapeCounts opponent{};
+
+    for (const auto &line : lines(record, side)) {
+        Evaluation::Evaluator::countShapes(line, own);
+    }
+
+    for (const auto &line : lines(record, static_cast<Stone>(-side))) {
+        Evaluation::Evaluator::countShapes(line, opponent);
+    }
+
+    // A finished game says nothing about the weights.
+    if (own[Evaluation::FIVE_SHAPE] || opponent[Evaluation::FIVE_SHAPE]) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sample.features.size(); ++i) {
+        sample.features[i] = static_cast<float>(own[i] - opponent[i]);
+    }
+
+    const auto winner = record.result == Game::Result::BlackWin   ? Black
+                        : record.result == Game::Result::WhiteWin ? White
+                                                                  : Empty;
+
+    sample.result = winner == Empty ? 0.5F : winner == side ? 1.0F : 0.0F;
+
+    return true;
+}
+
+double sigmoid(const double &x)
+{
+    return 1 / (1 + std::exp(-x));
+}
+
+double evaluate(const Sample &sample, const std::array<double, Evaluation::SHAPES.size()> &weights)
+{
+    double score = 0;
+
+    for (size_t i = 0; i < weights.size(); ++i) {
+        score += weights[i] * sample.features[i];
+    }
+
+    return score;
+}
+
+class Tuner
+{
+private:
+    const std::vector<Sample> &samples;
+    Algorithm::WorkStealingPool pool;
+    size_t chunkSize;
+
+public:
+    using Vector = std::array<double, Evaluation::SHAPES.size()>;
+
+    Tuner(const std::vector<Sample> &samples, const size_t &threads)
+        : samples(samples)
+        , pool(threads)
+        , chunkSize((samples.size() + 4 * threads - 1) / (4 * threads))
+    {}
+
+    // Mean squared error and its gradient, computed by chunks on the pool.
+    double error(const Vector &weights, const double &k, Vector *gradient)
+    {
+        const auto chunks = (samples.size() + chunkSize - 1) / chunkSize;
+        std::vector<double> errors(chunks);
+        std::vector<Vector> gradients(chunks);
+
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            pool.submit([&, chunk](const size_t &) {
+                const auto end = std::min(samples.size(), (chunk + 1) * chunkSize);
+
+                for (size_t i = chunk * chunkSize; i < end; ++i) {
+                    const auto &sample = samples[i];
+                    const auto prediction = sigmoid(k * evaluate(sample, weights));
+                    const auto difference = prediction - sample.result;
+
+                    errors[chunk] += difference * difference;
+
+                    if (gradient) {
+                        const auto factor = 2 * difference * prediction * (1 - prediction) * k;
+
+                        for (size_t j = 0; j < weights.size(); ++j) {
+                            gradients[chunk][j] += factor * sample.features[j];
+                        }
+                    }
+                }
+            });
+        }
+
+        pool.wait();
+
+        double total = 0;
+
+        if (gradient) {
+            gradient->fill(0);
+        }
+
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            total += errors[chunk];
+
+            if (gradient) {
+                for (size_t j = 0; j < weights.size(); ++j) {
+                    (*gradient)[j] += gradients[chunk][j] / samples.size();
+                }
+            }
+        }
+
+        return total / samples.size();
+    }
+
+    // Golden-section search of the scale k of the initial weights, on a log scale.
+    double fitK(const Vector &weights)
+    {
+        constexpr double ratio = 0.6180339887498949;
+
+        double low = std::log(1e-6);
+        double high = std::log(1e-1);
+
+        for (int i = 0; i < 60; ++i) {
+            const auto first = high - ratio * (high - low);
+            const auto second = low + ratio * (high - low);
+
+            if (error(weights, std::exp(first), nullptr) < error(weights, std::exp(second), nullptr)) {
+                high = second;
+            } else {
+                low = first;
+            }
+        }
+
+        return std::exp((low + high) / 2);
+    }
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    auto initial = Evaluation::defaultWeights();
+
+    if (!options.initial.empty()) {
+        const auto weights = Evaluation::loadWeights(options.initial);
+
+        if (!weights) {
+            std::cerr << "Cannot load the weights " << options.initial << '\n';
+
+            return EXIT_FAILURE;
+        }
+
+        initial = *weights;
+    }
+
+    Game::RecordReader reader;
+
+    if (!reader.open(options.data)) {
+        std::cerr << "Cannot open " << options.data << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Sample> samples;
+
+    for (const auto &record : reader) {
+        if (Sample sample{}; toSample(record, sample)) {
+            samples.push_back(sample);
+        }
+    }
+
+    if (samples.empty()) {
+        std::cerr << "No record with a result and without a five\n";
+
+        return EXIT_FAILURE;
+    }
+
+    Tuner tuner(samples, options.threads);
+    Tuner::Vector weights;
+    Tuner::Vector gradient;
+    // Adam moments, the weights span several orders of magnitude so the steps are normalized.
+    Tuner::Vector mean{};
+    Tuner::Vector variance{};
+
+    std::copy(initial.cbegin(), initial.cend(), weights.begin());
+
+    const auto k = options.k > 0 ? options.k : tuner.fitK(weights);
+
+    std::cerr << samples.size() << " samples, k = " << k
+              << ", initial error = " << tuner.error(weights, k, nullptr) << '\n';
+
+    for (int iteration = 1; iteration <= options.iterations; ++iteration) {
+        const auto error = tuner.error(weights, k, &gradient);
+
+        for (size_t i = 0; i < weights.size(); ++i) {
+            if (i == Evaluation::FIVE_SHAPE) {
+                continue;
+            }
+
+            mean[i] = 0.9 * mean[i] + 0.1 * gradient[i];
+            variance[i] = 0.999 * variance[i] + 0.001 * gradient[i] * gradient[i];
+
+            const auto correctedMean = mean[i] / (1 - std::pow(0.9, iteration));
+            const auto correctedVariance = variance[i] / (1 - std::pow(0.999, iteration));
+
+            weights[i] = std::clamp(weights[i]
+                                        - options.rate * correctedMean
+                                              / (std::sqrt(correctedVariance) + 1e-12),
+                                    0.0,
+                                    static_cast<double>(Five - 1));
+        }
+
+        if (iteration % 100 == 0 || iteration == options.iterations) {
+            std::cerr << "iteration " << iteration << ", error = " << error << '\n';
+        }
+    }
+
+    Evaluation::Weights tuned;
+
+    for (size_t i = 0; i < tuned.size(); ++i) {
+        tuned[i] = i == Evaluation::FIVE_SHAPE ? Five : static_cast<int>(std::lround(weights[i]));
+    }
+
+    if (!Evaluation::saveWeights(options.output, tuned)) {
+        std::cerr << "Cannot write " << options.output << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < tuned.size(); ++i) {
+        std::cout << Evaluation::SHAPES[i] << ' ' << initial[i] << " -> " << tuned[i] << '\n';
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,11 +1,27 @@
 #include "gamewindow.h"
+#include "../evaluation/weights.h"
 
+#include <QCoreApplication>
 #include <QCursor>
+#include <QDir>
 #include <QMessageBox>
 #include <QPainter>
+#include <QStandardPaths>
 #include <QtConcurrent>
 #include <QtEvents>
 
+namespace {
+Point toPoint(const QPoint &point)
+{
+    return {point.x(), point.y()};
+}
+
+QPoint toQPoint(const Point &point)
+{
+    return {point.x, point.y};
+}
+} // namespace
+
 GameWindow::GameWindow(QWidget *parent)
     : QMainWindow(parent)
     , last(QPoint(-1, -1))
@@ -16,6 +32,22 @@ GameWindow::GameWindow(QWidget *parent)
 {
     ui.setupUi(this);
 
+    // An opening book next to the executable is optional, without one the engine searches.
+    engine.setBook(Search::OpeningBook::open(
+        QDir(QCoreApplication::applicationDirPath()).filePath("book.bin").toStdString()));
+
+    // So are shape weights tuned by gomoku-tune, in weights.txt.
+    if (const auto weights = Evaluation::loadWeights(
+            QDir(QCoreApplication::applicationDirPath()).filePath("weights.txt").toStdString())) {
+        engine.setWeights(*weights);
+    }
+
+    // Proven results are kept across games and runs in the user's application data.
+    if (const QDir data(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+        data.mkpath(".")) {
+        engine.setSolvedStore(Search::SolvedStore::open(data.filePath("solved.bin").toStdString()));
+    }
+
     connect(qApp, &QApplication::aboutToQuit, &watcher, &QFutureWatcher<void>::waitForFinished);
     connect(&watcher, &QFutureWatcher<void>::finished, this, &GameWindow::on_async_finished);
 }
@@ -34,7 +66,7 @@ void GameWindow::mouseMoveEvent(QMouseEvent *event)
     if (x < 20 || x >= 620 || y < 40 || y >= 640) {
         setCursor(Qt::ArrowCursor);
     } else {
-        if (engine.checkStone(move) == Empty) {
+        if (engine.publishedBoard().board[move.x()][move.y()] == Empty) {
             setCursor(Qt::PointingHandCursor);
         } else {
             setCursor(Qt::ArrowCursor);
@@ -60,8 +92,8 @@ void GameWindow::mouseReleaseEvent(QMouseEvent *event)
         return;
     }
 
-    if (engine.checkStone(move) == Empty) {
-        engine.move(move, playerStone);
+    if (engine.checkStone(toPoint(move)) == Empty) {
+        engine.move(toPoint(move), playerStone);
     } else {
         return;
     }
@@ -69,12 +101,12 @@ void GameWindow::mouseReleaseEvent(QMouseEvent *event)
     update((last.y() + 1) * 40 - 21, (last.x() + 1) * 40 - 1, 42, 42);
 
     ui.undo->setEnabled(true);
-    last = engine.lastMove();
+    last = toQPoint(engine.lastMove());
     ++step;
 
     update((last.y() + 1) * 40 - 21, (last.x() + 1) * 40 - 1, 42, 42);
 
-    if (const auto gameState = engine.gameStatus(move, playerStone);
+    if (const auto gameState = engine.gameStatus(toPoint(move), playerStone);
         gameState == Draw || gameState == Win) {
         gameOver = true;
 
@@ -106,15 +138,11 @@ void GameWindow::mouseReleaseEvent(QMouseEvent *event)
     if (gameType == PVC) {
         ui.undo->setDisabled(true);
 
-        repaint((last.y() + 1) * 40 - 21, (last.x() + 1) * 40 - 1, 42, 42);
-        setUpdatesEnabled(false);
-
+        // The window keeps painting from the published board while the engine searches.
         future = QtConcurrent::run([this] {
             const auto stone = static_cast<const Stone>(-playerStone);
 
             engine.move(engine.bestMove(stone), stone);
-
-            last = engine.lastMove();
         });
 
         watcher.setFuture(future);
@@ -169,14 +197,17 @@ void GameWindow::paintEvent(QPaintEvent *event)
     painter.drawEllipse(475, 495, 10, 10);
     painter.drawEllipse(315, 335, 10, 10);
 
+    const auto snapshot = engine.publishedBoard();
+    const auto lastMove = toQPoint(snapshot.lastMove);
+
     for (int i = 0; i < 15; ++i) {
         for (int j = 0; j < 15; ++j) {
-            if (engine.checkStone(QPoint(i, j)) == Black) {
+            if (snapshot.board[i][j] == Black) {
                 brush.setColor(Qt::black);
 
                 painter.setBrush(brush);
                 painter.drawEllipse(QPoint((j + 1) * 40, (i + 1) * 40 + 20), 18, 18);
-            } else if (engine.checkStone(QPoint(i, j)) == White) {
+            } else if (snapshot.board[i][j] == White) {
                 brush.setColor(Qt::white);
 
                 painter.setPen(Qt::NoPen);
@@ -227,23 +258,23 @@ void GameWindow::paintEvent(QPaintEvent *event)
                          (move.x() + 1) * 40 + 30);
     }
 
-    if (last != QPoint(-1, -1)) {
-        painter.drawLine((last.y() + 1) * 40 - 1,
-                         (last.x() + 1) * 40 + 20,
-                         (last.y() + 1) * 40 - 6,
-                         (last.x() + 1) * 40 + 20);
-        painter.drawLine((last.y() + 1) * 40 + 1,
-                         (last.x() + 1) * 40 + 20,
-                         (last.y() + 1) * 40 + 6,
-                         (last.x() + 1) * 40 + 20);
-        painter.drawLine((last.y() + 1) * 40,
-                         (last.x() + 1) * 40 + 19,
-                         (last.y() + 1) * 40,
-                         (last.x() + 1) * 40 + 14);
-        painter.drawLine((last.y() + 1) * 40,
-                         (last.x() + 1) * 40 + 21,
-                         (last.y() + 1) * 40,
-                         (last.x() + 1) * 40 + 26);
+    if (lastMove != QPoint(-1, -1)) {
+        painter.drawLine((lastMove.y() + 1) * 40 - 1,
+                         (lastMove.x() + 1) * 40 + 20,
+                         (lastMove.y() + 1) * 40 - 6,
+                         (lastMove.x() + 1) * 40 + 20);
+        painter.drawLine((lastMove.y() + 1) * 40 + 1,
+                         (lastMove.x() + 1) * 40 + 20,
+                         (lastMove.y() + 1) * 40 + 6,
+                         (lastMove.x() + 1) * 40 + 20);
+        painter.drawLine((lastMove.y() + 1) * 40,
+                         (lastMove.x() + 1) * 40 + 19,
+                         (lastMove.y() + 1) * 40,
+                         (lastMove.x() + 1) * 40 + 14);
+        painter.drawLine((lastMove.y() + 1) * 40,
+                         (lastMove.x() + 1) * 40 + 21,
+                         (lastMove.y() + 1) * 40,
+                         (lastMove.x() + 1) * 40 + 26);
     }
 }
 
@@ -255,7 +286,7 @@ void GameWindow::setGame(const Stone &stone, const bool &type)
     if (playerStone == White && gameType == PVC) {
         engine.move(engine.bestMove(Black), Black);
 
-        last = engine.lastMove();
+        last = toQPoint(engine.lastMove());
     }
 }
 
@@ -263,7 +294,8 @@ void GameWindow::on_async_finished()
 {
     ui.undo->setEnabled(true);
 
-    setUpdatesEnabled(true);
+    last = toQPoint(engine.lastMove());
+
     repaint();
 
     const auto stone = static_cast<const Stone>(-playerStone);
@@ -342,7 +374,7 @@ void GameWindow::on_undo_released()
         playerStone = static_cast<const Stone>(-playerStone);
     }
 
-    last = engine.lastMove();
+    last = toQPoint(engine.lastMove());
 
     update();
 }
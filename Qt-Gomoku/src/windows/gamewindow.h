@@ -2,7 +2,7 @@
 #define GAMEWINDOW_H
 
 #include "../search/engine.h"
-#include "ui_GameWindow.h"
+#include "ui_gamewindow.h"
 
 #include <QFuture>
 #include <QFutureWatcher>
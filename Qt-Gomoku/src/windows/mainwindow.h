@@ -1,8 +1,8 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "GameWindow.h"
-#include "ui_MainWindow.h"
+#include "gamewindow.h"
+#include "ui_mainwindow.h"
 
 #include <QMainWindow>
 